@@ -0,0 +1,304 @@
+#include "sequentialCircuit.h"
+#include <iostream>
+#include <sstream>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <chrono>
+#include <random>
+
+using namespace logic;
+using Mode = SequentialCircuit::Gate::Mode;
+using enum Mode;
+using Engine = SolveOptions::Engine;
+
+
+
+
+// keeps results of benchmarked calls alive
+static volatile uint64_t sink;
+
+// run a benchmarked operation until the minimum time passed and
+// report the mean time per operation
+static void micro(const std::string& name, const std::string& filter, const std::function<uint64_t()>& operation)
+{
+    if (name.find(filter) == std::string::npos) return;
+
+    constexpr double minSeconds = 0.25;
+    uint64_t iterations = 0, result = 0;
+    double seconds = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t batch = 1; seconds < minSeconds; batch *= 2)
+    {
+        for (uint64_t i = 0; i < batch; i++)
+            result += operation();
+        iterations += batch;
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    sink = result;
+
+    std::cout << "{\"kind\": \"micro\", \"name\": \"" << name << "\""
+              << ", \"iterations\": " << iterations
+              << ", \"nsPerOp\": " << seconds * 1e9 / iterations << "}" << std::endl;
+}
+
+
+
+
+static const char* engineName(Engine engine)
+{
+    switch (engine)
+    {
+        case Engine::ENUMERATE:     return "enumerate";
+        case Engine::SAT:           return "sat";
+        case Engine::BIDIRECTIONAL: return "bidirectional";
+        case Engine::LOCAL:         return "local";
+    }
+    return "";
+}
+
+static void solve(
+    const std::string& name,
+    const std::string& filter,
+    TruthTable table,
+    const std::vector<uint8_t>& layerSizes,
+    const std::vector<Mode>& modes,
+    bool balanced,
+    Engine engine,
+    bool ordered = false
+) {
+    if (name.find(filter) == std::string::npos) return;
+
+    SearchStats stats;
+    SolveOptions options;
+    options.engine = engine;
+    options.orderCandidates = ordered;
+    options.progress = false;
+    options.stats = &stats;
+
+    // silence solver output to keep the results machine-readable
+    std::stringstream discard;
+    std::streambuf* buffer = std::cout.rdbuf(discard.rdbuf());
+
+    auto start = std::chrono::steady_clock::now();
+    auto circuit = SequentialCircuit::solve(layerSizes, table, modes, balanced, options);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout.rdbuf(buffer);
+
+    std::cout << "{\"kind\": \"solve\", \"name\": \"" << name << "\""
+              << ", \"engine\": \"" << engineName(engine) << "\""
+              << ", \"ordered\": " << (ordered ? "true" : "false")
+              << ", \"layerSizes\": [";
+    for (uint8_t i = 0; i < layerSizes.size(); i++)
+        std::cout << (i ? ", " : "") << (int)layerSizes[i];
+    std::cout << "], \"balanced\": " << (balanced ? "true" : "false")
+              << ", \"rows\": " << table.entries.size()
+              << ", \"found\": " << (circuit ? "true" : "false")
+              << ", \"seconds\": " << elapsed.count()
+              << ", \"firstSolutionSeconds\": " << stats.firstSolutionSeconds
+              << ", \"combinations\": " << stats.combinations
+              << ", \"outputChecks\": " << stats.outputChecks
+              << ", \"outputCandidates\": " << stats.outputCandidates
+              << ", \"rowsScanned\": " << stats.rowsScanned << "}" << std::endl;
+}
+
+// solve the single output tables of a table as one batch and one by one
+static void batch(
+    const std::string& name,
+    const std::string& filter,
+    const TruthTable& table,
+    uint8_t outputs,
+    const std::vector<uint8_t>& layerSizes,
+    const std::vector<Mode>& modes
+) {
+    if (name.find(filter) == std::string::npos) return;
+
+    std::vector<TruthTable> tables(outputs);
+    for (uint8_t o = 0; o < outputs; o++)
+        for (auto& entry : table.entries)
+            tables[o].entries.push_back({ entry.inputBits, entry.outputBits >> o & 1, entry.dontCareBits >> o & 1 });
+
+    SolveOptions options;
+    options.progress = false;
+
+    std::stringstream discard;
+    std::streambuf* buffer = std::cout.rdbuf(discard.rdbuf());
+
+    auto start = std::chrono::steady_clock::now();
+    auto circuits = SequentialCircuit::solveBatch(layerSizes, tables, modes, false, options);
+    std::chrono::duration<double> batchElapsed = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (auto& single : tables)
+        SequentialCircuit::solve(layerSizes, single, modes, false, options);
+    std::chrono::duration<double> singleElapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout.rdbuf(buffer);
+
+    uint64_t found = 0;
+    for (auto& circuit : circuits)
+        found += circuit.has_value();
+
+    std::cout << "{\"kind\": \"batch\", \"name\": \"" << name << "\""
+              << ", \"tables\": " << tables.size()
+              << ", \"found\": " << found
+              << ", \"seconds\": " << batchElapsed.count()
+              << ", \"singleSeconds\": " << singleElapsed.count() << "}" << std::endl;
+}
+
+
+
+
+// circuit of random hidden layers for the micro-benchmarks
+static SequentialCircuit randomCircuit(const std::vector<uint8_t>& layerSizes, std::mt19937_64& rng)
+{
+    static const Mode modes[] = { AND, OR, XOR, NAND, NOR, XNOR };
+
+    SequentialCircuit circuit;
+    circuit.layers.resize(layerSizes.size());
+    for (uint8_t l = 0, g = 0; l < layerSizes.size(); l++)
+    {
+        circuit.layers[l].inputOffset = 0;
+        circuit.layers[l].gateOffset = g;
+        for (uint8_t i = 0; i < layerSizes[l]; i++)
+        {
+            uint64_t inputMask = l ? rng() & ((1ul << g) - 1) : 0;
+            circuit.layers[l].gates.push_back({ l and !inputMask ? 1 : inputMask, l ? modes[rng() % 6] : IN });
+        }
+        g += layerSizes[l];
+    }
+    return circuit;
+}
+
+
+
+
+// writes one json object per benchmark and line, run from the
+// repository root to include the example tables
+int main(int argc, char** argv)
+{
+    // run only benchmarks whose name contains the filter
+    const std::string filter = argc > 1 ? argv[1] : "";
+
+    std::mt19937_64 rng(42);
+
+
+    // micro-benchmarks of the solver kernels
+
+    for (uint8_t inputs : { 4, 10 })
+    {
+        TruthTable table = TruthTable::random(inputs, 3, 1);
+        SequentialCircuit circuit = randomCircuit({ inputs, 6, 6, 3 }, rng);
+        ActivationTruthTable att = computeActivationTruthTable(circuit, table);
+        const std::string rows = "/" + std::to_string(table.entries.size()) + "rows";
+
+        // output gates see the last hidden layer only
+        circuit.layers.back().inputOffset = circuit.layers[2].gateOffset;
+
+        const auto& gate = circuit.layers[2].gates[0];
+        uint64_t activation = 0;
+        if (inputs == 4)
+            micro("getActivation/bits", filter, [&]{ return gate.getActivation(activation++); });
+        micro("getActivation/word" + rows, filter, [&]{ return gate.getActivation(att, activation++ % att.words); });
+
+        micro("computeActivationTruthTable" + rows, filter, [&]{ return computeActivationTruthTable(circuit, table).words; });
+        micro("updateActivationTruthTable" + rows, filter, [&]{ updateActivationTruthTable(circuit, att, 1); return att.activations.back(); });
+
+        // output layer of the circuit computing the target outputs
+        TruthTable reachable = table;
+        for (auto& entry : reachable.entries)
+            entry.outputBits = circuit.evaluate(entry.inputBits);
+        ActivationTruthTable reachableAtt = computeActivationTruthTable(circuit, reachable);
+        const std::vector<Mode> allModes = { AND, OR, XOR, NAND, NOR, XNOR };
+
+        micro("tryConstructOutputLayer/fail" + rows, filter, [&]{ return tryConstructOutputLayer(circuit, att, allModes); });
+        micro("tryConstructOutputLayer/pass" + rows, filter, [&]{ return tryConstructOutputLayer(circuit, reachableAtt, allModes); });
+    }
+
+    micro("uniqueCombinationsOI/4of6", filter, []{ return uniqueCombinationsOI(4, 6).size(); });
+    micro("uniqueCombinationsOI/6of3", filter, []{ return uniqueCombinationsOI(6, 3, false).size(); });
+
+    std::vector<std::vector<uint64_t>> v1 = uniqueCombinationsOI(3, 6), v2 = uniqueCombinationsOI(2, 6);
+    micro("cartesianProduct/56x21", filter, [&]{ return cartesianProduct(v1, v2).size(); });
+
+
+    // truth table ingestion of a generated table of 2^16 rows
+
+    {
+        TruthTable table = TruthTable::random(16, 8, 3, 0.1);
+        const auto directory = std::filesystem::temp_directory_path();
+        const std::string csv = (directory / "bench_table.csv").string();
+        const std::string binary = (directory / "bench_table.bin").string();
+
+        std::ofstream file(csv);
+        file << "input,  output, dont care,\n";
+        for (auto& entry : table.entries)
+            file << entry.inputBits << ", " << entry.outputBits << ", " << entry.dontCareBits << ",\n";
+        file.close();
+        table.writeBinary(binary);
+
+        micro("readCSV/65536rows", filter, [&]{ return TruthTable::readCSV(csv).entries.size(); });
+        micro("readBinary/65536rows", filter, [&]{ return TruthTable::readBinary(binary).entries.size(); });
+
+        std::filesystem::remove(csv);
+        std::filesystem::remove(binary);
+    }
+
+
+    // end-to-end solves of the example tables
+
+    if (std::filesystem::exists("ttables/4bit_popcount.csv"))
+    {
+        solve("ttables/4bit_popcount", filter, TruthTable::readCSV("ttables/4bit_popcount.csv"),
+              { 4, 3, 1, 3 }, { AND, XOR }, false, Engine::ENUMERATE);
+        solve("ttables/4bit_popcount", filter, TruthTable::readCSV("ttables/4bit_popcount.csv"),
+              { 4, 3, 1, 3 }, { AND, XOR }, false, Engine::SAT);
+        solve("ttables/4bit_popcount/ordered", filter, TruthTable::readCSV("ttables/4bit_popcount.csv"),
+              { 4, 3, 1, 3 }, { AND, XOR }, false, Engine::ENUMERATE, true);
+    }
+    if (std::filesystem::exists("ttables/greater_4_add_3.csv"))
+    {
+        solve("ttables/greater_4_add_3", filter, TruthTable::readCSV("ttables/greater_4_add_3.csv"),
+              { 4, 4, 4 }, { AND, OR, XOR, NAND, NOR, XNOR }, true, Engine::ENUMERATE);
+        solve("ttables/greater_4_add_3", filter, TruthTable::readCSV("ttables/greater_4_add_3.csv"),
+              { 4, 4, 4 }, { AND, OR, XOR, NAND, NOR, XNOR }, true, Engine::SAT);
+        solve("ttables/greater_4_add_3/ordered", filter, TruthTable::readCSV("ttables/greater_4_add_3.csv"),
+              { 4, 4, 4 }, { AND, OR, XOR, NAND, NOR, XNOR }, true, Engine::ENUMERATE, true);
+    }
+
+
+    // end-to-end solves of generated tables
+
+    for (Engine engine : { Engine::ENUMERATE, Engine::SAT })
+    {
+        solve("adder/2bit", filter, TruthTable::adder(2), { 4, 4, 3 }, { AND, XOR }, false, engine);
+        solve("popcount/3bit", filter, TruthTable::popcount(3), { 3, 2, 1, 2 }, { AND, XOR }, false, engine);
+        solve("comparator/2bit", filter, TruthTable::comparator(2), { 4, 4, 3 }, { AND, NOR, XOR }, false, engine);
+        solve("multiplexer/1select", filter, TruthTable::multiplexer(1), { 3, 1, 1, 1 }, { AND, XOR }, false, engine);
+        solve("random/4in", filter, TruthTable::random(4, 2, 7), { 4, 3, 2 }, { AND, OR, XOR, NAND, NOR, XNOR }, false, engine);
+        solve("random/5in/dontcare", filter, TruthTable::random(5, 1, 7, 0.5), { 5, 3, 1 }, { AND, OR, XOR, NAND, NOR, XNOR }, false, engine);
+    }
+
+    // larger tables, where most output gates fail on a few rows
+    solve("random/10in/wide", filter, TruthTable::random(10, 1, 3), { 10, 1, 1 }, { AND, OR, XOR, NAND, NOR, XNOR }, false, Engine::ENUMERATE);
+    solve("random/9in/dontcare/wide", filter, TruthTable::random(9, 1, 5, 0.5), { 9, 1, 1 }, { AND, OR, XOR, NAND, NOR, XNOR }, false, Engine::ENUMERATE);
+
+    // deeper balanced shapes, where the forward states repeat
+    for (Engine engine : { Engine::ENUMERATE, Engine::BIDIRECTIONAL })
+    {
+        solve("popcount/4bit/deep", filter, TruthTable::popcount(4), { 4, 4, 3, 3 }, { AND, XOR }, true, engine);
+        solve("popcount/4bit/deep/none", filter, TruthTable::popcount(4), { 4, 3, 3, 3 }, { AND, XOR }, true, engine);
+    }
+
+    // larger shapes, searched by the local search within its time budget
+    solve("adder/3bit/local", filter, TruthTable::adder(3), { 6, 8, 8, 4 }, { AND, OR, XOR }, false, Engine::LOCAL);
+    solve("comparator/3bit/local", filter, TruthTable::comparator(3), { 6, 8, 6, 3 }, { AND, OR, XOR, NAND, NOR }, false, Engine::LOCAL);
+
+    // output bits of one function over a shared enumeration
+    batch("adder/2bit/outputs", filter, TruthTable::adder(2), 3, { 4, 3, 2, 1 }, { AND, OR, XOR, NAND });
+    batch("comparator/2bit/outputs", filter, TruthTable::comparator(2), 3, { 4, 3, 2, 1 }, { AND, OR, XOR, NAND });
+
+    return 0;
+}
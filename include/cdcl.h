@@ -0,0 +1,104 @@
+#pragma once
+#include <vector>
+#include <inttypes.h>
+#include <atomic>
+
+
+
+
+namespace logic
+{
+
+    // conflict driven clause learning SAT solver with two watched
+    // literals, first UIP clause learning, VSIDS decisions with
+    // phase saving, luby restarts and learnt clause reduction
+    struct CDCLSolver
+    {
+        // literal of variable v is 2v, its negation 2v + 1
+        using Literal = uint32_t;
+
+        static Literal literal(uint32_t variable, bool negated = false) { return 2 * variable + negated; }
+
+        enum class Result : uint8_t
+        {
+            SAT,
+            UNSAT,
+            UNKNOWN
+        };
+
+        uint32_t newVariable();
+        uint32_t variables() const { return assigns.size(); }
+
+        // add clause at decision level 0, returns false if
+        // the clauses became unsatisfiable
+        bool addClause(std::vector<Literal> clause);
+
+        // search until a model is found, unsatisfiability is proven,
+        // the conflict limit is reached or the search is cancelled
+        Result solve(uint64_t conflictLimit = UINT64_MAX, const std::atomic<bool>* cancel = nullptr);
+
+        // variable assignment of the last model
+        bool value(uint32_t variable) const { return model[variable]; }
+
+        uint64_t conflicts    = 0;
+        uint64_t decisions    = 0;
+        uint64_t propagations = 0;
+
+    private:
+        static constexpr int32_t noReason = -1;
+
+        struct Clause
+        {
+            std::vector<Literal> literals;
+            uint32_t lbd;
+            bool learnt;
+            bool deleted;
+        };
+
+        // literal value, 1 true, 0 false, -1 unassigned
+        int8_t literalValue(Literal l) const
+        {
+            int8_t v = assigns[l >> 1];
+            return v < 0 ? v : v ^ (l & 1);
+        }
+
+        void enqueue(Literal l, int32_t reason);
+        int32_t propagate();
+        void analyze(int32_t conflict, std::vector<Literal>& learnt, uint32_t& backtrackLevel);
+        void backtrack(uint32_t level);
+        void attach(uint32_t clause);
+        void reduceLearnts();
+        uint32_t decisionLevel() const { return trailLimits.size(); }
+
+        void bumpVariable(uint32_t variable);
+        void heapInsert(uint32_t variable);
+        void heapUp(uint32_t position);
+        void heapDown(uint32_t position);
+        uint32_t heapPop();
+
+        bool ok = true;
+
+        std::vector<Clause> clauses;
+        std::vector<std::vector<uint32_t>> watches;
+
+        std::vector<int8_t>   assigns;
+        std::vector<bool>     polarity;
+        std::vector<bool>     model;
+        std::vector<uint32_t> levels;
+        std::vector<int32_t>  reasons;
+        std::vector<uint8_t>  seen;
+
+        std::vector<Literal>  trail;
+        std::vector<uint32_t> trailLimits;
+        uint64_t propagateHead = 0;
+
+        std::vector<double>   activity;
+        std::vector<uint32_t> heap;
+        std::vector<int32_t>  heapIndices;
+        double variableIncrement = 1.0;
+
+        uint64_t learnts = 0;
+        uint64_t nextReduce = 2000;
+    };
+
+};
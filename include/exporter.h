@@ -0,0 +1,44 @@
+#pragma once
+#include "sequentialCircuit.h"
+
+
+
+
+// circuits compiled to straight-line code with one bitwise expression
+// per gate, gates no output depends on are left out, names of the
+// generated functions and modules must be identifiers
+namespace logic::exporter
+{
+
+    // standalone C++ header of a bit-sliced function of the name,
+    // bit k of inputs[i] and outputs[o] is input and output bit of
+    // row k, the function is a template over the word type for any
+    // integer or vector type with bitwise operators, an overload
+    // evaluates columns of words of uint64_t
+    template<typename Wires>
+    std::string cppHeader(const BasicSequentialCircuit<Wires>& circuit, const std::string& name);
+
+    // Verilog module of the name with input and output vectors
+    template<typename Wires>
+    std::string verilog(const BasicSequentialCircuit<Wires>& circuit, const std::string& name);
+
+    // C++ program including the header of the name, which evaluates
+    // the generated function on all rows of the truth table with 64
+    // and 256 rows per word and compares it with the table and the
+    // interpreted circuit, exits with 1 if any output bit differs
+    template<typename Wires>
+    std::string harness(
+        const BasicSequentialCircuit<Wires>& circuit,
+        const BasicTruthTable<Wires>& truthTable,
+        const std::string& name);
+
+    // write <name>.h, <name>.v and <name>_check.cpp to the directory,
+    // throws if a file can not be written
+    template<typename Wires>
+    void write(
+        const BasicSequentialCircuit<Wires>& circuit,
+        const BasicTruthTable<Wires>& truthTable,
+        const std::string& directory,
+        const std::string& name);
+
+};
@@ -0,0 +1,60 @@
+#pragma once
+#include "sequentialCircuit.h"
+
+
+
+
+// gate evaluation kernels over bit-sliced activation columns, the
+// kernels for the widest instruction set supported by the host are
+// selected at runtime with a scalar fallback
+namespace logic::kernels
+{
+
+    enum class Level : uint8_t
+    {
+        SCALAR,
+        AVX2,
+        AVX512
+    };
+
+    struct Kernels
+    {
+        Level level;
+
+        // words of rows processed per instruction
+        uint64_t width;
+
+        // write the activation column of a gate for all words
+        void (*gateActivations)(
+            const uint64_t* activations,
+            uint64_t words,
+            uint64_t inputMask,
+            SequentialCircuit::Gate::Mode mode,
+            uint64_t* column);
+
+        // evaluate all six gate modes for an input mask at once and
+        // return the mode options matching the target column in all
+        // rows that are cared for, stops early without options left
+        uint8_t (*modeOptions)(
+            const uint64_t* activations,
+            uint64_t words,
+            uint64_t inputMask,
+            const uint64_t* target,
+            const uint64_t* dontCare,
+            uint8_t options);
+    };
+
+    // widest kernel level supported by the host cpu
+    Level supported();
+
+    // kernels of a level, falling back to the widest supported one
+    const Kernels& get(Level level);
+
+    // kernels of the widest supported level, chosen once
+    const Kernels& active();
+
+    // check that all supported kernel levels agree with the scalar
+    // kernels for all input masks and modes over the truth table
+    bool selfTest(const TruthTable& truthTable);
+
+};
@@ -3,6 +3,9 @@
 #include <inttypes.h>
 #include <optional>
 #include <string>
+#include <functional>
+#include <memory>
+#include "wires.h"
 
 
 
@@ -10,84 +13,703 @@
 namespace logic
 {
 
-    struct TruthTable
+    struct ActivationTruthTable;
+
+
+    // truth table over input and output bits held in a wire state,
+    // uint64_t for up to 64 bits or WideWires for wider tables
+    template<typename Wires>
+    struct BasicTruthTable
     {
         struct Entry
         {
-            uint64_t inputBits;
-            uint64_t outputBits;
-            uint64_t dontCareBits;
+            Wires inputBits;
+            Wires outputBits;
+            Wires dontCareBits;
         };
 
         std::vector<Entry> entries;
 
-        static TruthTable readCSV(std::string filename);
+        // number of input and output bits used by the entries
+        uint16_t inputWidth() const;
+        uint16_t outputWidth() const;
+
+        // csv of decimal input, output and dont care bits per row
+        // following a header line, throws with the line of invalid rows
+        static BasicTruthTable readCSV(std::string filename);
+
+        // binary table of packed rows, loaded from a memory mapping
+        static BasicTruthTable readBinary(std::string filename);
+        void writeBinary(std::string filename) const;
+
+        // binary or csv table, told apart by the binary header
+        static BasicTruthTable read(std::string filename);
+
+        // hash of all entries, identifies the table in checkpoints,
+        // equal for tables of the same bits in any wire state
+        uint64_t hash() const;
+
+        // rows caring for any of the first outputs, which are those of
+        // the circuit, rows of equal inputs merged unless they differ in
+        // an output both care for, in order of the first row merged,
+        // keeps one row of a table without cared outputs
+        BasicTruthTable compacted(uint16_t outputs) const;
+
+        // generated tables over all input combinations
+
+        // sum of two operands of bits each, inputs a | b << bits
+        static BasicTruthTable adder(uint8_t bits);
+
+        // number of set input bits
+        static BasicTruthTable popcount(uint8_t bits);
+
+        // a < b, a == b and a > b of two operands, inputs a | b << bits
+        static BasicTruthTable comparator(uint8_t bits);
+
+        // data input selected by the low select bits, 
+        // data inputs following the select bits
+        static BasicTruthTable multiplexer(uint8_t selectBits);
+
+        // random outputs, each output bit dont care with the given rate
+        static BasicTruthTable random(uint8_t inputs, uint8_t outputs, uint64_t seed, double dontCareRate = 0);
+
+        // same entries in another wire state, bits beyond its capacity are dropped
+        template<typename To> BasicTruthTable<To> convert() const;
+    };
+
+    using TruthTable = BasicTruthTable<uint64_t>;
+    using WideTruthTable = BasicTruthTable<WideWires<8>>;
+
+
+    struct LayerBuilder;
+
+    template<typename Wires>
+    struct SearchSink;
+
+    template<typename Wires>
+    struct SearchBatch;
+
+    template<typename Wires>
+    struct LocalSearchResult;
+
+
+    // counters of the enumeration search, each thread counts into its
+    // own instance, which are summed when the search ends
+    struct SearchStats
+    {
+        uint64_t combinations = 0;          // circuit combinations visited
+        uint64_t skipped = 0;               // combinations skipped by pruned layers
+        uint64_t layersUnranked = 0;
+        uint64_t prunedRedundant = 0;
+        uint64_t prunedEquivalent = 0;
+        uint64_t prunedBound = 0;           // layers exceeding the cost bound
+        uint64_t outputChecks = 0;          // candidates reaching the output layer
+        uint64_t rejectedInseparable = 0;   // rows with equal visible wires differ
+        uint64_t cacheHits = 0;
+        uint64_t outputCandidates = 0;      // output gates checked against the rows
+        uint64_t rowsScanned = 0;           // upper bound, rows of the checked gates
+        uint64_t middleStates = 0;          // distinct states joined by the bidirectional search
+        uint64_t cachedResults = 0;         // searches answered by the solution cache
+        uint64_t localMoves = 0;            // gate mutations of the local search
+        uint64_t localRestarts = 0;
+
+        double buildSeconds = 0;            // preparing layer builders
+        double searchSeconds = 0;
+        double firstSolutionSeconds = 0;    // search start to the first solution found
+
+        SearchStats& operator+=(const SearchStats& other);
+
+        std::string toJSON() const;
     };
 
 
-    struct SequentialCircuit
+    struct SolveOptions
     {
-        struct Gate
+        enum class Engine : uint8_t
         {
-            enum class Mode : uint8_t
-            {
-                IN   = 0b000,
-
-                AND  = 0b001,
-                OR   = 0b010,
-                XOR  = 0b011,
-                
-                NAND = 0b101,
-                NOR  = 0b110,
-                XNOR = 0b111
-            };
-
-            uint64_t inputMask;
-            Mode mode;
-
-            // gate activation 0 or 1
-            uint64_t getActivation(uint64_t activation) const;
+            ENUMERATE,      // exhaustive search over layer combinations
+            SAT,            // CNF encoding solved by the in-tree CDCL solver
+            BIDIRECTIONAL,  // distinct activations of the first hidden layers
+                            // joined with searches of the remaining layers
+            LOCAL           // simulated annealing over gate modes and inputs,
+                            // finds solutions without proving their absence
         };
 
+        Engine engine = Engine::ENUMERATE;
+
+        // number of search threads, 0 for hardware concurrency
+        unsigned threads = 1;
+
+        // always return the solution with the lowest circuit
+        // combination index, same as the single threaded search
+        bool deterministic = true;
+
+        // skip hidden layers with the same activation signature as a
+        // layer already searched under the same preceding layers
+        bool pruneEquivalent = true;
+
+        // compare layer signatures independent of the gate order, layers
+        // computing the same functions as a searched layer in another 
+        // order only permute the wires seen by the following layers
+        bool pruneSymmetric = true;
+
+        // search the first hidden layer of the enumeration in order of
+        // a heuristic score, solutions tend to be found earlier and are
+        // the lowest combination of the reordered enumeration
+        bool orderCandidates = false;
+
+        // skip hidden layers emitting constant columns or duplicates
+        // of wires visible to the following layers, may miss solutions
+        // of layers wider than the distinct columns they can compute,
+        // or whose following gates need a duplicated wire
+        bool pruneRedundant = false;
+
+        // print progress at most once per interval in seconds
+        bool progress = true;
+        double progressInterval = 0.5;
+
+        // accumulate counters of all searches if set
+        SearchStats* stats = nullptr;
+
+        // search only the shard of equal parts of the circuit 
+        // combination index range, for independent processes
+        uint64_t shard = 0;
+        uint64_t shards = 1;
+
+        // file to resume the search from, and to write the search
+        // state to periodically and when the search ends
+        std::string checkpoint;
+        double checkpointInterval = 60;
+
+        // directory of the solution cache, consulted before and updated
+        // after searches of all circuit combinations if set
+        std::string cache;
+
+        // time budget in seconds of the local search, and the seed
+        // of the random restarts of its threads
+        double localSeconds = 10;
+        uint64_t seed = 0;
+
+        // bits of the pruning and ordering options, which change the
+        // enumerated combinations and the solution found first
+        uint8_t enumerationFlags() const
+        { return pruneEquivalent | pruneSymmetric << 1 | pruneRedundant << 2 | orderCandidates << 3; }
+    };
+
+
+    enum class GateMode : uint8_t
+    {
+        IN   = 0b000,
+
+        AND  = 0b001,
+        OR   = 0b010,
+        XOR  = 0b011,
+        
+        NAND = 0b101,
+        NOR  = 0b110,
+        XNOR = 0b111
+    };
+
+    template<typename Wires>
+    struct BasicGate
+    {
+        using Mode = GateMode;
+
+        Wires inputMask;
+        Mode mode;
+
+        // gate activation 0 or 1
+        uint64_t getActivation(Wires activation) const;
+
+        // gate activations of 64 truth table rows packed in
+        // one word of the bit-sliced activation truth table
+        uint64_t getActivation(const ActivationTruthTable& activationTruthTable, uint64_t word) const;
+    };
+
+    template<typename Wires>
+    struct BasicLayer
+    {
+        std::vector<BasicGate<Wires>> gates;
+        uint16_t inputOffset;
+        uint16_t gateOffset;
+    };
+
+
+    // cost of a circuit as the sum over its hidden and output gates,
+    // weights are expected to be non-negative
+    struct CostModel
+    {
+        double gate  = 1;           // per gate
+        double input = 0;           // per gate input
+        double modes[8] = {};       // per gate of a mode, indexed by GateMode
+
+        double gateCost(GateMode mode, unsigned inputs) const
+        { return gate + input * inputs + modes[uint8_t(mode)]; }
+    };
+
+
+    // circuit over a wire state holding all of its wires, the search
+    // runs with the narrowest wire state holding the circuit, so the
+    // widest instantiation solves circuits of any supported width
+    template<typename Wires>
+    struct BasicSequentialCircuit
+    {
+        using Gate = BasicGate<Wires>;
+        using Layer = BasicLayer<Wires>;
+        using TruthTable = BasicTruthTable<Wires>;
+
+        static std::optional<BasicSequentialCircuit> solve(
+            std::vector<uint8_t> layerSizes,
+            TruthTable& truthTable,
+            std::vector<GateMode> modes,
+            bool balanced = true,
+            const SolveOptions& options = {});
+
+        // search circuit combinations of prepared hidden layer builders
+        // for modes in ascending order, solutions are passed to the sink
+        // instead of returning the first one if set, the output layer
+        // is checked against each table of the batch instead if set
+        static std::optional<BasicSequentialCircuit> search(
+            const std::vector<uint8_t>& layerSizes,
+            const std::vector<LayerBuilder>& layerBuilders,
+            const TruthTable& truthTable,
+            const std::vector<GateMode>& modes,
+            bool balanced,
+            const SolveOptions& options,
+            SearchSink<Wires>* sink = nullptr,
+            SearchBatch<Wires>* batch = nullptr);
+
+        // enumerate the hidden layers up to a middle layer and search
+        // the remaining layers once for each distinct activation state
+        // they produce, as a circuit with the state as inputs, same
+        // solution as search, layers that can not tell apart rows of
+        // different outputs are skipped in balanced circuits
+        static std::optional<BasicSequentialCircuit> searchBidirectional(
+            const std::vector<uint8_t>& layerSizes,
+            const std::vector<LayerBuilder>& layerBuilders,
+            const TruthTable& truthTable,
+            const std::vector<GateMode>& modes,
+            bool balanced,
+            const SolveOptions& options);
+
+        // called for each solution, the search ends when it returns false
+        using SolutionCallback = std::function<bool(const BasicSequentialCircuit&)>;
+
+        // stream all circuits of the layer sizes satisfying the truth
+        // table, in combination order with a single thread and in any
+        // order with more, calls are serialized, hidden layers pruned
+        // as equivalent or redundant are not searched
+        static void solveAll(
+            std::vector<uint8_t> layerSizes,
+            const TruthTable& truthTable,
+            std::vector<GateMode> modes,
+            const SolutionCallback& onSolution,
+            bool balanced = true,
+            const SolveOptions& options = {});
+
+        // the k cheapest circuits under the cost model, cheapest first
+        // and equal costs by combination, output gates are the cheapest
+        // per position and combinations whose cost can not beat the 
+        // k-th circuit are skipped, hidden layers equivalent to a layer
+        // searched at no higher cost are skipped, which of them depends
+        // on the chunks of the search, the cheapest cost does not
+        static std::vector<BasicSequentialCircuit> solveBest(
+            std::vector<uint8_t> layerSizes,
+            const TruthTable& truthTable,
+            std::vector<GateMode> modes,
+            uint64_t k,
+            const CostModel& cost = {},
+            bool balanced = true,
+            const SolveOptions& options = {});
+
+        // circuit of the layer sizes for each table, the hidden layers 
+        // are enumerated once over the input rows of all tables and the
+        // output layer is checked for each table without a solution yet,
+        // the solutions of solve for tables of the same input rows
+        static std::vector<std::optional<BasicSequentialCircuit>> solveBatch(
+            std::vector<uint8_t> layerSizes,
+            const std::vector<TruthTable>& truthTables,
+            std::vector<GateMode> modes,
+            bool balanced = true,
+            const SolveOptions& options = {});
+
+        // search layer size configurations of the number of outputs in
+        // increasing order of total hidden gates and depth, return the
+        // first circuit found within the hidden gate budget, the number
+        // of outputs is given, outputs of cared zeros in all rows set no
+        // bits the table could be measured by
+        static std::optional<BasicSequentialCircuit> solveMinimal(
+            const TruthTable& truthTable,
+            uint8_t outputs,
+            std::vector<GateMode> modes,
+            uint8_t gateBudget,
+            bool balanced = true,
+            const SolveOptions& options = {});
+
+        // circuit of the fewest mismatched cared output bits found by
+        // restarts of simulated annealing on all threads, which mutate
+        // single gates and rescore only their downstream cone, until
+        // the time budget is spent or a circuit satisfies the table
+        static LocalSearchResult<Wires> solveLocal(
+            std::vector<uint8_t> layerSizes,
+            const TruthTable& truthTable,
+            std::vector<GateMode> modes,
+            bool balanced = true,
+            const SolveOptions& options = {});
+
+        // encode gate modes, input masks and wire activations of all
+        // truth table rows as CNF and solve it with the CDCL solver,
+        // the solver counters are printed with progress
+        static std::optional<BasicSequentialCircuit> solveSAT(
+            const std::vector<uint8_t>& layerSizes,
+            const TruthTable& truthTable,
+            const std::vector<GateMode>& modes,
+            bool balanced = true,
+            const SolveOptions& options = {});
+
+        // output bits of the circuit for the input bits
+        Wires evaluate(const Wires& inputBits) const;
+
+        // true if the outputs match the cared output bits of the 
+        // circuit outputs in all rows of the table
+        bool satisfies(const TruthTable& truthTable) const;
+
+        // sum of the gate costs of the hidden and output layers
+        double cost(const CostModel& model = {}) const;
+
+        // same gates in another wire state, wires beyond its capacity are dropped
+        template<typename To> BasicSequentialCircuit<To> convert() const;
+
+        std::vector<Layer> layers;
+    };
+
+    using SequentialCircuit = BasicSequentialCircuit<uint64_t>;
+    using WideSequentialCircuit = BasicSequentialCircuit<WideWires<8>>;
+
+
+    // best circuit of a local search, satisfying the truth table
+    // if no cared output bits mismatch
+    template<typename Wires>
+    struct LocalSearchResult
+    {
+        BasicSequentialCircuit<Wires> circuit;
+        uint64_t mismatches = 0;
+    };
+
+
+    template<typename Wires>
+    template<typename To>
+    BasicTruthTable<To> BasicTruthTable<Wires>::convert() const
+    {
+        BasicTruthTable<To> table;
+        table.entries.reserve(entries.size());
+        for (auto& entry : entries)
+            table.entries.push_back({ convertWires<To>(entry.inputBits),
+                convertWires<To>(entry.outputBits), convertWires<To>(entry.dontCareBits) });
+        return table;
+    }
+
+    template<typename Wires>
+    template<typename To>
+    BasicSequentialCircuit<To> BasicSequentialCircuit<Wires>::convert() const
+    {
+        BasicSequentialCircuit<To> circuit;
+        for (auto& layer : layers)
+        {
+            auto& converted = circuit.layers.emplace_back();
+            converted.inputOffset = layer.inputOffset;
+            converted.gateOffset = layer.gateOffset;
+            for (auto& gate : layer.gates)
+                converted.gates.push_back({ convertWires<To>(gate.inputMask), gate.mode });
+        }
+        return circuit;
+    }
+
+
+    // circuit with the gates of all layers in one contiguous array
+    // indexed by wire, followed by the output gates, the search
+    // mutates it in place without allocating per combination
+    template<typename Wires>
+    struct BasicFlatCircuit
+    {
+        using Gate = BasicGate<Wires>;
+
         struct Layer
         {
-            std::vector<Gate> gates;
-            uint8_t inputOffset;
-            uint8_t gateOffset;
+            uint16_t inputOffset;
+            uint16_t gateOffset;
+            uint8_t size;
         };
 
-        static std::optional<SequentialCircuit> solve(
-            std::vector<uint8_t> layerSizes,
-            TruthTable& truthTable,
-            std::vector<Gate::Mode> modes,
-            bool balanced = true);
+        BasicFlatCircuit(const std::vector<uint8_t>& layerSizes, bool balanced);
+
+        Gate*       layerGates(uint8_t layer)       { return gates.data() + layers[layer].gateOffset; }
+        const Gate* layerGates(uint8_t layer) const { return gates.data() + layers[layer].gateOffset; }
+
+        // copy gates into a circuit of separate layers
+        BasicSequentialCircuit<Wires> materialize() const;
 
+        std::vector<Gate> gates;
         std::vector<Layer> layers;
     };
 
+    using FlatCircuit = BasicFlatCircuit<uint64_t>;
+
+
+    // search state of the circuit combination range of a shard, 
+    // all combinations below next are searched, circuits of up to
+    // 64 wires are checkpointed
+    struct Checkpoint
+    {
+        // problem of the search
+        uint64_t tableHash = 0;
+        std::vector<uint8_t> layerSizes;
+        std::vector<GateMode> modes;
+        bool balanced = true;
+        std::vector<uint64_t> layerCounts;  // enumerated combinations per hidden layer
+        uint8_t enumeration = 0;            // SolveOptions::enumerationFlags of the search
+
+        uint64_t begin = 0;
+        uint64_t end = 0;
+        uint64_t next = 0;
+
+        // lowest solution found in the range
+        std::optional<uint64_t> found;
+        std::optional<SequentialCircuit> solution;
+
+        bool complete() const { return found or next >= end; }
+
+        // true if both checkpoints search the same problem
+        bool compatible(const Checkpoint& other) const;
+
+        // written to a temporary file first, which replaces the file
+        void write(const std::string& filename) const;
+        static std::optional<Checkpoint> read(const std::string& filename);
+
+        // first solution of the shards covering all circuit combinations,
+        // throws if shards are incompatible, incomplete or missing
+        static std::optional<SequentialCircuit> merge(std::vector<Checkpoint> shards);
+    };
+
+
+    // results of searched layer sizes kept on disk across runs, with 
+    // a file per problem in the directory named by its key, circuits
+    // of up to 64 wires are cached
+    struct SolutionCache
+    {
+        std::string directory;
+
+        // hash of the table compacted to the outputs with rows in 
+        // input order, the outputs, the sorted modes, balance and the
+        // engine and pruning options, which change the results
+        static uint64_t key(
+            const TruthTable& truthTable,
+            uint16_t outputs,
+            std::vector<GateMode> modes,
+            bool balanced,
+            const SolveOptions& options);
+
+        struct Result
+        {
+            bool cached = false;
+            std::optional<SequentialCircuit> solution;
+        };
+
+        // cached solution of the layer sizes verified on the table, or
+        // no solution if the layer sizes have none, results of other
+        // layer sizes are not used, the enumeration of wider layers 
+        // does not include the circuits of narrower ones
+        Result lookup(
+            const TruthTable& truthTable,
+            const std::vector<uint8_t>& layerSizes,
+            const std::vector<GateMode>& modes,
+            bool balanced,
+            const SolveOptions& options) const;
+
+        // append the result of a search of all circuit combinations
+        void store(
+            const TruthTable& truthTable,
+            const std::vector<uint8_t>& layerSizes,
+            const std::vector<GateMode>& modes,
+            bool balanced,
+            const SolveOptions& options,
+            const std::optional<SequentialCircuit>& solution) const;
+    };
+
+
+    // lazy enumeration of the unique gate mode and connection
+    // combinations of a hidden layer, layers are unranked from
+    // their combination index on demand
+    struct LayerBuilder
+    {
+        LayerBuilder(
+            uint8_t size,
+            uint16_t inputOffset,
+            uint16_t gateOffset,
+            const std::vector<GateMode>& modes,
+            bool balanced);
+
+        // write layer at combination index, or at the position
+        // in the selection of combination indices if selected
+        template<typename Wires>
+        void unrank(uint64_t index, BasicLayer<Wires>& layer) const;
+
+        // write the gates of the layer at combination index in place
+        template<typename Wires>
+        void unrank(uint64_t index, BasicGate<Wires>* gates) const;
+
+        // combination index of layer
+        template<typename Wires>
+        uint64_t rank(const BasicLayer<Wires>& layer) const;
+
+        // number of enumerated layer combinations
+        uint64_t count() const { return selected ? selection->size() : combinations; }
+
+        // gates of the same mode with distinct connections
+        struct Group
+        {
+            uint8_t mode;
+            uint8_t positions;
+            bool filtered;
+            uint64_t combinations;
+        };
 
-    // compressed truth table format containing input bits, gate 
+        struct ModeCombo
+        {
+            uint64_t first;
+            uint64_t combinations;
+            std::vector<Group> groups;
+        };
+
+        uint8_t size;
+        uint16_t inputOffset;
+        uint16_t gateOffset;
+        std::vector<GateMode> modes;
+        std::vector<ModeCombo> modeCombos;
+        uint64_t gateCons;
+        uint64_t combinations;
+
+        // optional subset of combination indices to enumerate in order,
+        // shared by copies of the builder
+        bool selected = false;
+        std::shared_ptr<const std::vector<uint64_t>> selection;
+    };
+
+
+    // select the combinations of a first hidden layer builder with 
+    // distinct activation signatures that are not redundant
+    template<typename Wires>
+    void selectDistinctFirstLayers(
+        LayerBuilder& builder,
+        const BasicTruthTable<Wires>& truthTable,
+        bool balanced,
+        const SolveOptions& options);
+
+    // order the combinations of a first hidden layer builder by their
+    // heuristic score, layers whose joint activations leave the least
+    // entropy of the cared outputs first, then layers of more distinct
+    // activations and fewer gate inputs, builders of more than 16 gates
+    // or 2^24 combinations keep their order
+    template<typename Wires>
+    void orderFirstLayers(
+        LayerBuilder& builder,
+        const BasicTruthTable<Wires>& truthTable,
+        bool balanced);
+
+
+    // bit-sliced truth table format containing input bits, gate 
     // activations throughout the circuit, and the target output bits
-    // pair: (input | activations | output << n, dontCareBits)
-    using ActivationTruthTable = std::vector<std::pair<uint64_t, uint64_t>>;
+    // each wire is a column of row bits, packed 64 rows per word,
+    // rows padding the last word are marked as dont care
+    struct ActivationTruthTable
+    {
+        uint64_t rows  = 0;
+        uint64_t words = 0;
+
+        // columns of input and gate activations, indexed by wire
+        std::vector<uint64_t> activations;
+
+        // columns of target output and dont care bits, indexed by output
+        std::vector<uint64_t> outputs;
+        std::vector<uint64_t> dontCares;
+
+        uint64_t*       wire(uint64_t index)           { return activations.data() + index * words; }
+        const uint64_t* wire(uint64_t index) const     { return activations.data() + index * words; }
+        const uint64_t* output(uint64_t index) const   { return outputs.data()     + index * words; }
+        const uint64_t* dontCare(uint64_t index) const { return dontCares.data()   + index * words; }
+    };
+
+    // rows that rejected recent output gate candidates, their bits are
+    // gathered into a single word per column, which candidates are
+    // checked against before the full columns of larger tables
+    struct KillerRows
+    {
+        static constexpr uint8_t capacity = 64;
+
+        std::vector<uint64_t> rows;
+        uint8_t next = 0;   // slot of the oldest row once all are taken
+
+        // gathered bits of the visible wires, the target outputs and 
+        // the cared outputs, bit i of each word taken from rows[i]
+        std::vector<uint64_t> visible;
+        std::vector<uint64_t> outputs;
+        std::vector<uint64_t> cares;
+    };
     
     // compute full circuit activations for all truth table inputs 
+    template<typename Wires>
     ActivationTruthTable computeActivationTruthTable(
-        const SequentialCircuit& circuit,
-        const TruthTable& truthTable);
+        const BasicSequentialCircuit<Wires>& circuit,
+        const BasicTruthTable<Wires>& truthTable);
+
+    template<typename Wires>
+    ActivationTruthTable computeActivationTruthTable(
+        const BasicFlatCircuit<Wires>& circuit,
+        const BasicTruthTable<Wires>& truthTable);
 
     // update truth table for layer at layerIndex and following layers
+    template<typename Wires>
     void updateActivationTruthTable(
-        const SequentialCircuit& circuit,
+        const BasicSequentialCircuit<Wires>& circuit,
         ActivationTruthTable& activationTruthTable,
         uint8_t layerIndex);
 
-    // return true if an output layer can be constructed,
-    // which satisfies the truth table
+    // update truth table for the gates of a single layer
+    template<typename Wires>
+    void updateLayerActivations(
+        const BasicLayer<Wires>& layer,
+        ActivationTruthTable& activationTruthTable);
+
+    template<typename Wires>
+    void updateLayerActivations(
+        const BasicFlatCircuit<Wires>& circuit,
+        uint8_t layerIndex,
+        ActivationTruthTable& activationTruthTable);
+
+    // return true if an output layer can be constructed, which
+    // satisfies the truth table, of the first gates found per 
+    // position or the cheapest under the cost model if set, the
+    // construction is specialized on the base modes of the modes,
+    // while hidden gates are evaluated by their mode per gate
+    template<typename Wires>
     bool tryConstructOutputLayer(
-        SequentialCircuit& circuit, 
+        BasicSequentialCircuit<Wires>& circuit, 
         const ActivationTruthTable& activationTruthTable,
-        const std::vector<SequentialCircuit::Gate::Mode> modes);
+        const std::vector<GateMode> modes);
+
+    template<typename Wires>
+    bool tryConstructOutputLayer(
+        BasicFlatCircuit<Wires>& circuit, 
+        const ActivationTruthTable& activationTruthTable,
+        const std::vector<GateMode>& modes,
+        SearchStats* stats = nullptr,
+        const CostModel* cost = nullptr,
+        KillerRows* killers = nullptr);
+
+    // check that the output gates constructed for every mode set by the
+    // construction specialized on its base modes agree with the generic
+    // construction of all modes, for output layers over the table inputs
+    bool selfTestOutputGates(const TruthTable& truthTable);
 };
 
 
@@ -96,6 +718,9 @@ namespace logic
 uint64_t combinationsWReplacementsRec(uint64_t n, uint64_t k);
 uint64_t combinationsWReplacements(uint64_t n, uint64_t k);
 
+// binomial coefficient, saturating at UINT64_MAX
+uint64_t binomial(uint64_t n, uint64_t k);
+
 
 // unique order-independent combinations for
 // placing items of m types at k positions
@@ -130,13 +755,13 @@ std::vector<std::vector<T>> cartesianProduct(
 
 namespace std
 {
-    std::string to_string(const logic::SequentialCircuit::Gate::Mode& mode);
-    std::string to_string(const logic::SequentialCircuit::Gate& gate);
-    std::string to_string(const logic::SequentialCircuit::Layer& layer);
-    std::string to_string(const logic::SequentialCircuit& circuit);
+    std::string to_string(const logic::GateMode& mode);
+    template<typename Wires> std::string to_string(const logic::BasicGate<Wires>& gate);
+    template<typename Wires> std::string to_string(const logic::BasicLayer<Wires>& layer);
+    template<typename Wires> std::string to_string(const logic::BasicSequentialCircuit<Wires>& circuit);
     
-    std::ostream& operator<<(std::ostream &out, const logic::SequentialCircuit::Gate::Mode& mode);
-    std::ostream& operator<<(std::ostream &out, const logic::SequentialCircuit::Gate& gate);
-    std::ostream& operator<<(std::ostream &out, const logic::SequentialCircuit::Layer& layer);
-    std::ostream& operator<<(std::ostream &out, const logic::SequentialCircuit& circuit);
-};
+    std::ostream& operator<<(std::ostream &out, const logic::GateMode& mode);
+    template<typename Wires> std::ostream& operator<<(std::ostream &out, const logic::BasicGate<Wires>& gate);
+    template<typename Wires> std::ostream& operator<<(std::ostream &out, const logic::BasicLayer<Wires>& layer);
+    template<typename Wires> std::ostream& operator<<(std::ostream &out, const logic::BasicSequentialCircuit<Wires>& circuit);
+};
\ No newline at end of file
@@ -0,0 +1,187 @@
+#pragma once
+#include <inttypes.h>
+#include <type_traits>
+
+
+
+
+namespace logic
+{
+
+    // wire state of Words 64 bit words for circuits with more than
+    // 64 wires, circuits of up to 64 wires use uint64_t directly
+    template<unsigned Words>
+    struct WideWires
+    {
+        uint64_t words[Words] = {};
+
+        constexpr WideWires() = default;
+        constexpr WideWires(uint64_t low) : words{ low } {}
+
+        constexpr WideWires& operator&=(const WideWires& other) { for (unsigned i = 0; i < Words; i++) words[i] &= other.words[i]; return *this; }
+        constexpr WideWires& operator|=(const WideWires& other) { for (unsigned i = 0; i < Words; i++) words[i] |= other.words[i]; return *this; }
+        constexpr WideWires& operator^=(const WideWires& other) { for (unsigned i = 0; i < Words; i++) words[i] ^= other.words[i]; return *this; }
+
+        friend constexpr WideWires operator&(WideWires a, const WideWires& b) { return a &= b; }
+        friend constexpr WideWires operator|(WideWires a, const WideWires& b) { return a |= b; }
+        friend constexpr WideWires operator^(WideWires a, const WideWires& b) { return a ^= b; }
+
+        constexpr WideWires operator~() const
+        {
+            WideWires w;
+            for (unsigned i = 0; i < Words; i++) w.words[i] = ~words[i];
+            return w;
+        }
+
+        constexpr WideWires operator<<(unsigned shift) const
+        {
+            WideWires w;
+            for (unsigned i = Words; i-- > shift / 64;)
+            {
+                w.words[i] = words[i - shift / 64] << (shift % 64);
+                if (shift % 64 and i > shift / 64)
+                    w.words[i] |= words[i - shift / 64 - 1] >> (64 - shift % 64);
+            }
+            return w;
+        }
+
+        constexpr WideWires operator>>(unsigned shift) const
+        {
+            WideWires w;
+            for (unsigned i = 0; i + shift / 64 < Words; i++)
+            {
+                w.words[i] = words[i + shift / 64] >> (shift % 64);
+                if (shift % 64 and i + shift / 64 + 1 < Words)
+                    w.words[i] |= words[i + shift / 64 + 1] << (64 - shift % 64);
+            }
+            return w;
+        }
+
+        constexpr WideWires operator+(const WideWires& other) const
+        {
+            WideWires w;
+            uint64_t carry = 0;
+            for (unsigned i = 0; i < Words; i++)
+            {
+                w.words[i] = words[i] + other.words[i] + carry;
+                carry = w.words[i] < words[i] or (carry and w.words[i] == words[i]);
+            }
+            return w;
+        }
+
+        constexpr bool operator==(const WideWires& other) const = default;
+
+        explicit constexpr operator bool() const
+        {
+            for (unsigned i = 0; i < Words; i++) if (words[i]) return true;
+            return false;
+        }
+    };
+
+
+    // number of wires a wire state holds
+    template<typename Wires> constexpr unsigned wireCapacity = 64;
+    template<unsigned Words> constexpr unsigned wireCapacity<WideWires<Words>> = 64 * Words;
+
+    // wire state of half the capacity, used to search with the
+    // narrowest wire state holding all wires of a circuit
+    template<typename Wires> struct HalfWiresOf { using type = uint64_t; };
+    template<unsigned Words> struct HalfWiresOf<WideWires<Words>>
+    { using type = std::conditional_t<Words == 2, uint64_t, WideWires<Words / 2>>; };
+    template<typename Wires> using HalfWires = typename HalfWiresOf<Wires>::type;
+
+
+    // wire state operations for uint64_t and WideWires
+
+    constexpr uint64_t lowWord(uint64_t wires) { return wires; }
+    template<unsigned Words> constexpr uint64_t lowWord(const WideWires<Words>& wires) { return wires.words[0]; }
+
+    constexpr bool testWire(uint64_t wires, unsigned wire) { return wires >> wire & 1; }
+    template<unsigned Words> constexpr bool testWire(const WideWires<Words>& wires, unsigned wire)
+    { return wires.words[wire / 64] >> (wire % 64) & 1; }
+
+    template<typename Wires> constexpr Wires wireBit(unsigned wire) { return Wires(1) << wire; }
+
+    // wires below count, all wires of the state from its capacity on
+    template<typename Wires> constexpr Wires lowWires(unsigned count)
+    { return count >= wireCapacity<Wires> ? ~Wires(0) : ~(~Wires(0) << count); }
+
+    // index of the lowest wire set, wires must not be empty
+    constexpr unsigned lowestWire(uint64_t wires) { return __builtin_ctzll(wires); }
+    template<unsigned Words> constexpr unsigned lowestWire(const WideWires<Words>& wires)
+    {
+        unsigned i = 0;
+        while (!wires.words[i]) i++;
+        return 64 * i + __builtin_ctzll(wires.words[i]);
+    }
+
+    constexpr void clearLowestWire(uint64_t& wires) { wires &= wires - 1; }
+    template<unsigned Words> constexpr void clearLowestWire(WideWires<Words>& wires)
+    {
+        unsigned i = 0;
+        while (!wires.words[i]) i++;
+        wires.words[i] &= wires.words[i] - 1;
+    }
+
+    constexpr unsigned wireCount(uint64_t wires) { return __builtin_popcountll(wires); }
+    template<unsigned Words> constexpr unsigned wireCount(const WideWires<Words>& wires)
+    {
+        unsigned count = 0;
+        for (unsigned i = 0; i < Words; i++) count += __builtin_popcountll(wires.words[i]);
+        return count;
+    }
+
+    constexpr unsigned wireParity(uint64_t wires) { return __builtin_parityll(wires); }
+    template<unsigned Words> constexpr unsigned wireParity(const WideWires<Words>& wires)
+    {
+        uint64_t parity = 0;
+        for (unsigned i = 0; i < Words; i++) parity ^= wires.words[i];
+        return __builtin_parityll(parity);
+    }
+
+    // order of wire states by their highest differing word
+    constexpr bool wiresLess(uint64_t a, uint64_t b) { return a < b; }
+    template<unsigned Words> constexpr bool wiresLess(const WideWires<Words>& a, const WideWires<Words>& b)
+    {
+        for (unsigned i = Words; i-- > 0;)
+            if (a.words[i] != b.words[i]) return a.words[i] < b.words[i];
+        return false;
+    }
+
+    // index of the highest wire set plus one, 0 without wires
+    constexpr unsigned wireWidth(uint64_t wires) { return wires ? 64 - __builtin_clzll(wires) : 0; }
+    template<unsigned Words> constexpr unsigned wireWidth(const WideWires<Words>& wires)
+    {
+        for (unsigned i = Words; i-- > 0;)
+            if (wires.words[i]) return 64 * i + 64 - __builtin_clzll(wires.words[i]);
+        return 0;
+    }
+
+    // copy the words of a wire state into one of another capacity,
+    // wires beyond the capacity are dropped
+    template<typename To, typename From> constexpr To convertWires(const From& wires)
+    {
+        if constexpr (std::is_same_v<To, From>)
+            return wires;
+        else if constexpr (std::is_same_v<To, uint64_t>)
+            return lowWord(wires);
+        else if constexpr (std::is_same_v<From, uint64_t>)
+            return To(wires);
+        else
+        {
+            To to;
+            for (unsigned i = 0; i < wireCapacity<To> / 64 and i < wireCapacity<From> / 64; i++)
+                to.words[i] = wires.words[i];
+            return to;
+        }
+    }
+
+};
+
+
+// expand a macro for each wire state the solver is instantiated for
+#define LOGIC_FOR_EACH_WIRES(X) \
+    X(uint64_t) \
+    X(logic::WideWires<2>) \
+    X(logic::WideWires<4>) \
+    X(logic::WideWires<8>)
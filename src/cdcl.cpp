@@ -0,0 +1,442 @@
+#include "cdcl.h"
+#include <algorithm>
+
+using namespace logic;
+
+
+
+
+// luby sequence 1, 1, 2, 1, 1, 2, 4, ... for restart intervals
+static uint64_t luby(uint64_t i)
+{
+    uint64_t size = 1, seq = 0;
+    while (size < i + 1)
+    {
+        seq++;
+        size = 2 * size + 1;
+    }
+    while (size - 1 != i)
+    {
+        size = (size - 1) >> 1;
+        seq--;
+        i = i % size;
+    }
+    return 1ul << seq;
+}
+
+
+
+
+uint32_t CDCLSolver::newVariable()
+{
+    uint32_t v = assigns.size();
+
+    assigns.push_back(-1);
+    polarity.push_back(false);
+    levels.push_back(0);
+    reasons.push_back(noReason);
+    seen.push_back(0);
+    activity.push_back(0.0);
+    heapIndices.push_back(-1);
+    watches.resize(2 * assigns.size());
+
+    heapInsert(v);
+    return v;
+}
+
+
+
+
+bool CDCLSolver::addClause(std::vector<Literal> clause)
+{
+    if (!ok) return false;
+
+    // remove duplicate and false literals, skip satisfied clauses
+    std::sort(clause.begin(), clause.end());
+    clause.erase(std::unique(clause.begin(), clause.end()), clause.end());
+
+    uint32_t j = 0;
+    for (uint32_t i = 0; i < clause.size(); i++)
+    {
+        if (literalValue(clause[i]) == 1) return true;
+        if (i + 1 < clause.size() and clause[i + 1] == (clause[i] ^ 1)) return true;
+        if (literalValue(clause[i]) == 0) continue;
+        clause[j++] = clause[i];
+    }
+    clause.resize(j);
+
+    if (clause.empty())
+        return ok = false;
+
+    if (clause.size() == 1)
+    {
+        enqueue(clause[0], noReason);
+        return ok = propagate() == noReason;
+    }
+
+    clauses.push_back({ std::move(clause), 0, false, false });
+    attach(clauses.size() - 1);
+    return true;
+}
+
+
+
+
+void CDCLSolver::attach(uint32_t clause)
+{
+    const auto& literals = clauses[clause].literals;
+    watches[literals[0]].push_back(clause);
+    watches[literals[1]].push_back(clause);
+}
+
+
+
+
+void CDCLSolver::enqueue(Literal l, int32_t reason)
+{
+    assigns[l >> 1] = !(l & 1);
+    levels[l >> 1] = decisionLevel();
+    reasons[l >> 1] = reason;
+    trail.push_back(l);
+}
+
+
+
+
+int32_t CDCLSolver::propagate()
+{
+    while (propagateHead < trail.size())
+    {
+        // clauses watching the literal that became false
+        Literal falseLiteral = trail[propagateHead++] ^ 1;
+        std::vector<uint32_t>& watchers = watches[falseLiteral];
+        propagations++;
+
+        uint32_t i = 0, j = 0;
+        while (i < watchers.size())
+        {
+            uint32_t c = watchers[i++];
+            Clause& clause = clauses[c];
+            if (clause.deleted) continue;
+
+            auto& literals = clause.literals;
+            if (literals[0] == falseLiteral)
+                std::swap(literals[0], literals[1]);
+
+            if (literalValue(literals[0]) == 1)
+            {
+                watchers[j++] = c;
+                continue;
+            }
+
+            // look for a new literal to watch
+            bool moved = false;
+            for (uint32_t k = 2; k < literals.size(); k++)
+                if (literalValue(literals[k]) != 0)
+                {
+                    std::swap(literals[1], literals[k]);
+                    watches[literals[1]].push_back(c);
+                    moved = true;
+                    break;
+                }
+            if (moved) continue;
+
+            // clause is unit or conflicting
+            watchers[j++] = c;
+            if (literalValue(literals[0]) == 0)
+            {
+                while (i < watchers.size())
+                    watchers[j++] = watchers[i++];
+                watchers.resize(j);
+                propagateHead = trail.size();
+                return c;
+            }
+            enqueue(literals[0], c);
+        }
+        watchers.resize(j);
+    }
+    return noReason;
+}
+
+
+
+
+void CDCLSolver::analyze(int32_t conflict, std::vector<Literal>& learnt, uint32_t& backtrackLevel)
+{
+    learnt.assign(1, 0);
+
+    // resolve conflict with reasons of the current decision
+    // level until a single literal of that level remains
+    uint32_t pathCount = 0;
+    Literal p = 0;
+    bool first = true;
+    int64_t index = trail.size() - 1;
+
+    do
+    {
+        const auto& literals = clauses[conflict].literals;
+        for (uint32_t k = first ? 0 : 1; k < literals.size(); k++)
+        {
+            uint32_t v = literals[k] >> 1;
+            if (seen[v] or levels[v] == 0) continue;
+
+            seen[v] = 1;
+            bumpVariable(v);
+            if (levels[v] >= decisionLevel()) pathCount++;
+            else learnt.push_back(literals[k]);
+        }
+
+        while (!seen[trail[index] >> 1]) index--;
+        p = trail[index--];
+        conflict = reasons[p >> 1];
+        seen[p >> 1] = 0;
+        pathCount--;
+        first = false;
+    }
+    while (pathCount > 0);
+
+    learnt[0] = p ^ 1;
+
+
+    // remove literals implied by other literals of the clause
+    const std::vector<Literal> analyzed = learnt;
+    uint32_t j = 1;
+    for (uint32_t i = 1; i < learnt.size(); i++)
+    {
+        int32_t reason = reasons[learnt[i] >> 1];
+        bool redundant = reason != noReason;
+        if (redundant)
+            for (uint32_t k = 1; k < clauses[reason].literals.size(); k++)
+            {
+                uint32_t v = clauses[reason].literals[k] >> 1;
+                if (!seen[v] and levels[v] > 0)
+                {
+                    redundant = false;
+                    break;
+                }
+            }
+        if (!redundant) learnt[j++] = learnt[i];
+    }
+    learnt.resize(j);
+    for (uint32_t i = 1; i < analyzed.size(); i++)
+        seen[analyzed[i] >> 1] = 0;
+
+
+    // move literal of the highest remaining level to the second
+    // position to be watched after backtracking
+    backtrackLevel = 0;
+    for (uint32_t i = 1; i < learnt.size(); i++)
+        if (levels[learnt[i] >> 1] > backtrackLevel)
+        {
+            backtrackLevel = levels[learnt[i] >> 1];
+            std::swap(learnt[1], learnt[i]);
+        }
+}
+
+
+
+
+void CDCLSolver::backtrack(uint32_t level)
+{
+    if (decisionLevel() <= level) return;
+
+    for (uint64_t i = trail.size(); i > trailLimits[level]; i--)
+    {
+        uint32_t v = trail[i - 1] >> 1;
+        polarity[v] = assigns[v];
+        assigns[v] = -1;
+        reasons[v] = noReason;
+        if (heapIndices[v] < 0) heapInsert(v);
+    }
+
+    trail.resize(trailLimits[level]);
+    trailLimits.resize(level);
+    propagateHead = trail.size();
+}
+
+
+
+
+void CDCLSolver::reduceLearnts()
+{
+    std::vector<uint32_t> candidates;
+    for (uint32_t c = 0; c < clauses.size(); c++)
+    {
+        const Clause& clause = clauses[c];
+        if (!clause.learnt or clause.deleted or clause.lbd <= 2) continue;
+
+        // keep clauses that are reasons of current assignments
+        Literal l = clause.literals[0];
+        if (literalValue(l) == 1 and reasons[l >> 1] == (int32_t)c) continue;
+
+        candidates.push_back(c);
+    }
+
+    // delete the half with the highest literal block distance
+    std::sort(candidates.begin(), candidates.end(), [&](uint32_t a, uint32_t b)
+        { return clauses[a].lbd > clauses[b].lbd; });
+    for (uint32_t i = 0; i < candidates.size() / 2; i++)
+    {
+        clauses[candidates[i]].deleted = true;
+        clauses[candidates[i]].literals = {};
+        learnts--;
+    }
+}
+
+
+
+
+CDCLSolver::Result CDCLSolver::solve(uint64_t conflictLimit, const std::atomic<bool>* cancel)
+{
+    if (!ok or propagate() != noReason)
+    {
+        ok = false;
+        return Result::UNSAT;
+    }
+
+    std::vector<Literal> learnt;
+    uint64_t restarts = 0;
+    uint64_t restartConflicts = conflicts + 100 * luby(restarts);
+    uint64_t startConflicts = conflicts;
+
+    while (true)
+    {
+        int32_t conflict = propagate();
+        if (conflict != noReason)
+        {
+            conflicts++;
+            if (decisionLevel() == 0)
+            {
+                ok = false;
+                return Result::UNSAT;
+            }
+
+            uint32_t backtrackLevel;
+            analyze(conflict, learnt, backtrackLevel);
+            backtrack(backtrackLevel);
+
+            if (learnt.size() == 1)
+                enqueue(learnt[0], noReason);
+            else
+            {
+                // literal block distance of the learnt clause
+                std::vector<uint32_t> blocks;
+                for (Literal l : learnt) blocks.push_back(levels[l >> 1]);
+                std::sort(blocks.begin(), blocks.end());
+                uint32_t lbd = std::unique(blocks.begin(), blocks.end()) - blocks.begin();
+
+                clauses.push_back({ learnt, lbd, true, false });
+                attach(clauses.size() - 1);
+                enqueue(learnt[0], clauses.size() - 1);
+                learnts++;
+            }
+
+            variableIncrement /= 0.95;
+            continue;
+        }
+
+        if (conflicts - startConflicts >= conflictLimit or
+            (cancel and cancel->load(std::memory_order_relaxed)))
+        {
+            backtrack(0);
+            return Result::UNKNOWN;
+        }
+
+        if (conflicts >= restartConflicts)
+        {
+            backtrack(0);
+            restartConflicts = conflicts + 100 * luby(++restarts);
+        }
+
+        if (learnts >= nextReduce)
+        {
+            reduceLearnts();
+            nextReduce += 300;
+        }
+
+        // decide on the most active unassigned variable
+        uint32_t v = UINT32_MAX;
+        while (!heap.empty())
+        {
+            v = heapPop();
+            if (assigns[v] < 0) break;
+            v = UINT32_MAX;
+        }
+
+        if (v == UINT32_MAX)
+        {
+            model.resize(assigns.size());
+            for (uint32_t i = 0; i < assigns.size(); i++)
+                model[i] = assigns[i] == 1;
+            backtrack(0);
+            return Result::SAT;
+        }
+
+        decisions++;
+        trailLimits.push_back(trail.size());
+        enqueue(literal(v, !polarity[v]), noReason);
+    }
+}
+
+
+
+
+void CDCLSolver::bumpVariable(uint32_t variable)
+{
+    if ((activity[variable] += variableIncrement) > 1e100)
+    {
+        for (double& a : activity) a *= 1e-100;
+        variableIncrement *= 1e-100;
+    }
+    if (heapIndices[variable] >= 0)
+        heapUp(heapIndices[variable]);
+}
+
+void CDCLSolver::heapInsert(uint32_t variable)
+{
+    heapIndices[variable] = heap.size();
+    heap.push_back(variable);
+    heapUp(heap.size() - 1);
+}
+
+void CDCLSolver::heapUp(uint32_t position)
+{
+    uint32_t v = heap[position];
+    while (position > 0 and activity[heap[(position - 1) / 2]] < activity[v])
+    {
+        heap[position] = heap[(position - 1) / 2];
+        heapIndices[heap[position]] = position;
+        position = (position - 1) / 2;
+    }
+    heap[position] = v;
+    heapIndices[v] = position;
+}
+
+void CDCLSolver::heapDown(uint32_t position)
+{
+    uint32_t v = heap[position];
+    while (2 * position + 1 < heap.size())
+    {
+        uint32_t child = 2 * position + 1;
+        if (child + 1 < heap.size() and activity[heap[child + 1]] > activity[heap[child]])
+            child++;
+        if (activity[heap[child]] <= activity[v]) break;
+
+        heap[position] = heap[child];
+        heapIndices[heap[position]] = position;
+        position = child;
+    }
+    heap[position] = v;
+    heapIndices[v] = position;
+}
+
+uint32_t CDCLSolver::heapPop()
+{
+    uint32_t v = heap.front();
+    heap.front() = heap.back();
+    heapIndices[heap.front()] = 0;
+    heap.pop_back();
+    heapIndices[v] = -1;
+    if (!heap.empty()) heapDown(0);
+    return v;
+}
@@ -0,0 +1,167 @@
+#include "sequentialCircuit.h"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdio>
+
+using namespace logic;
+
+
+
+
+bool Checkpoint::compatible(const Checkpoint& other) const
+{
+    return tableHash   == other.tableHash   and
+           layerSizes  == other.layerSizes  and
+           modes       == other.modes       and
+           balanced    == other.balanced    and
+           layerCounts == other.layerCounts and
+           enumeration == other.enumeration;
+}
+
+
+
+
+// one key and its values per line, the solution is written as
+// input offset, gate offset, then input mask and mode per gate
+void Checkpoint::write(const std::string& filename) const
+{
+    const std::string temporary = filename + ".tmp";
+    {
+        std::ofstream file(temporary);
+        if (!file.is_open())
+            throw std::runtime_error("Cannot write checkpoint " + temporary + ".");
+
+        file << "table " << tableHash << "\n";
+
+        file << "layers";
+        for (uint8_t size : layerSizes) file << " " << (int)size;
+        file << "\nmodes";
+        for (auto mode : modes) file << " " << (int)mode;
+        file << "\nbalanced " << balanced << "\ncounts";
+        for (uint64_t count : layerCounts) file << " " << count;
+        file << "\nenumeration " << (int)enumeration;
+
+        file << "\nrange " << begin << " " << end << "\n";
+        file << "next " << next << "\n";
+
+        if (found and solution)
+        {
+            file << "found " << *found << "\n";
+            for (auto& layer : solution->layers)
+            {
+                file << "layer " << (int)layer.inputOffset << " " << (int)layer.gateOffset;
+                for (auto& gate : layer.gates)
+                    file << " " << gate.inputMask << " " << (int)gate.mode;
+                file << "\n";
+            }
+        }
+
+        if (!file.flush())
+            throw std::runtime_error("Cannot write checkpoint " + temporary + ".");
+    }
+
+    if (std::rename(temporary.c_str(), filename.c_str()) != 0)
+        throw std::runtime_error("Cannot replace checkpoint " + filename + ".");
+}
+
+std::optional<Checkpoint> Checkpoint::read(const std::string& filename)
+{
+    std::ifstream file(filename);
+    if (!file.is_open()) return {};
+
+    Checkpoint checkpoint;
+    std::string line, key;
+    while (std::getline(file, line))
+    {
+        std::istringstream values(line);
+        values >> key;
+
+        uint64_t value;
+        if (key == "table")
+            values >> checkpoint.tableHash;
+        else if (key == "layers")
+            while (values >> value) checkpoint.layerSizes.push_back(value);
+        else if (key == "modes")
+            while (values >> value) checkpoint.modes.push_back((SequentialCircuit::Gate::Mode)value);
+        else if (key == "balanced")
+            values >> checkpoint.balanced;
+        else if (key == "counts")
+            while (values >> value) checkpoint.layerCounts.push_back(value);
+        else if (key == "enumeration")
+        {
+            values >> value;
+            checkpoint.enumeration = value;
+        }
+        else if (key == "range")
+            values >> checkpoint.begin >> checkpoint.end;
+        else if (key == "next")
+            values >> checkpoint.next;
+        else if (key == "found")
+        {
+            values >> value;
+            checkpoint.found = value;
+            checkpoint.solution.emplace();
+        }
+        else if (key == "layer" and checkpoint.solution)
+        {
+            SequentialCircuit::Layer layer;
+            values >> value; layer.inputOffset = value;
+            values >> value; layer.gateOffset = value;
+
+            uint64_t mask, mode;
+            while (values >> mask >> mode)
+                layer.gates.push_back({ mask, (SequentialCircuit::Gate::Mode)mode });
+            checkpoint.solution->layers.push_back(layer);
+        }
+        else
+            throw std::runtime_error("Invalid checkpoint " + filename + ": " + line);
+
+        if (values.fail() and !values.eof())
+            throw std::runtime_error("Invalid checkpoint " + filename + ": " + line);
+    }
+
+    if (checkpoint.solution and checkpoint.solution->layers.size() != checkpoint.layerSizes.size())
+        throw std::runtime_error("Invalid checkpoint " + filename + ": incomplete solution");
+
+    return checkpoint;
+}
+
+
+
+
+std::optional<SequentialCircuit> Checkpoint::merge(std::vector<Checkpoint> shards)
+{
+    if (shards.empty())
+        throw std::invalid_argument("Merge expects at least one checkpoint.");
+
+    std::sort(shards.begin(), shards.end(),
+        [](const Checkpoint& a, const Checkpoint& b){ return a.begin < b.begin; });
+
+    uint64_t total = 1;
+    for (uint64_t count : shards.front().layerCounts)
+        if (__builtin_mul_overflow(total, count, &total))
+            throw std::overflow_error("Circuit combinations exceed the 64 bit index range.");
+
+    // shards in order of their ranges, the first solution is only
+    // the first overall if all preceding shards are complete
+    uint64_t covered = 0;
+    for (auto& shard : shards)
+    {
+        if (!shard.compatible(shards.front()))
+            throw std::invalid_argument("Checkpoints of different problems can not be merged.");
+        if (shard.begin != covered)
+            throw std::invalid_argument("Checkpoints do not cover the range from " + std::to_string(covered) + ".");
+        if (!shard.complete())
+            throw std::runtime_error("Shard of range from " + std::to_string(shard.begin) + " is incomplete.");
+
+        if (shard.found)
+            return shard.solution;
+        covered = shard.end;
+    }
+
+    if (covered != total)
+        throw std::invalid_argument("Checkpoints do not cover the range from " + std::to_string(covered) + ".");
+    return {};
+}
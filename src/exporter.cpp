@@ -0,0 +1,295 @@
+#include "exporter.h"
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <filesystem>
+#include <functional>
+#include <cctype>
+#include <stdexcept>
+
+using namespace logic;
+
+
+
+
+static void checkName(const std::string& name)
+{
+    bool identifier = !name.empty() and !std::isdigit((unsigned char)name.front());
+    for (char c : name)
+        identifier = identifier and (std::isalnum((unsigned char)c) or c == '_');
+    if (!identifier)
+        throw std::invalid_argument("Export expects an identifier as name, got \"" + name + "\".");
+}
+
+// wires an output depends on, indexed by wire
+template<typename Wires>
+static std::vector<bool> liveWires(const BasicSequentialCircuit<Wires>& circuit)
+{
+    std::vector<bool> live(circuit.layers.back().gateOffset);
+    auto mark = [&](const BasicGate<Wires>& gate)
+    {
+        if (!gate.inputMask)
+            throw std::invalid_argument("Export expects gates with at least one input.");
+        for (Wires mask = gate.inputMask; mask; clearLowestWire(mask))
+            live.at(lowestWire(mask)) = true;
+    };
+
+    for (auto& gate : circuit.layers.back().gates)
+        mark(gate);
+    for (uint8_t l = circuit.layers.size() - 1; l-- > 1;)
+        for (uint8_t g = 0; g < circuit.layers[l].gates.size(); g++)
+            if (live[circuit.layers[l].gateOffset + g])
+                mark(circuit.layers[l].gates[g]);
+    return live;
+}
+
+// operands of the gate joined by its operator, negated modes
+// invert the result, operators are the same in C++ and Verilog
+template<typename Wires>
+static std::string expression(const BasicGate<Wires>& gate, const std::function<std::string(unsigned)>& operand)
+{
+    static const char* operators[] = { "", " & ", " | ", " ^ " };
+
+    std::string e;
+    for (Wires mask = gate.inputMask; mask; clearLowestWire(mask))
+        e += (e.empty() ? "" : operators[uint8_t(gate.mode) & 3]) + operand(lowestWire(mask));
+
+    if (uint8_t(gate.mode) & 4)
+        return wireCount(gate.inputMask) > 1 ? "~(" + e + ")" : "~" + e;
+    return e;
+}
+
+
+
+
+template<typename Wires>
+std::string exporter::cppHeader(const BasicSequentialCircuit<Wires>& circuit, const std::string& name)
+{
+    checkName(name);
+    const std::vector<bool> live = liveWires(circuit);
+    const uint16_t nInputs  = circuit.layers.front().gates.size();
+    const uint16_t nOutputs = circuit.layers.back().gates.size();
+    auto operand = [](unsigned wire) { return "w" + std::to_string(wire); };
+
+    std::stringstream ss;
+    ss << "// generated by the sequential logic solver, " << nInputs << " inputs and " << nOutputs << " outputs\n"
+       << "// bit-sliced evaluation, bit k of inputs[i] and outputs[o] is input\n"
+       << "// bit i and output bit o of row k, Word is any integer or vector\n"
+       << "// type with bitwise operators\n"
+       << "#pragma once\n"
+       << "#include <stddef.h>\n"
+       << "#include <stdint.h>\n"
+       << "\n"
+       << "template<typename Word>\n"
+       << "inline void " << name << "(const Word* inputs, Word* outputs)\n"
+       << "{\n";
+
+    for (uint16_t i = 0; i < nInputs; i++)
+        if (live[i])
+            ss << "    const Word " << operand(i) << " = inputs[" << i << "];\n";
+
+    for (uint8_t l = 1; l < circuit.layers.size() - 1; l++)
+        for (uint8_t g = 0; g < circuit.layers[l].gates.size(); g++)
+        {
+            const uint16_t wire = circuit.layers[l].gateOffset + g;
+            if (live[wire])
+                ss << "    const Word " << operand(wire) << " = " << expression(circuit.layers[l].gates[g], operand) << ";\n";
+        }
+
+    for (uint16_t o = 0; o < nOutputs; o++)
+        ss << "    outputs[" << o << "] = " << expression(circuit.layers.back().gates[o], operand) << ";\n";
+
+    ss << "}\n"
+       << "\n"
+       << "// columns of words each, inputs[i * words + k] and outputs[o * words + k]\n"
+       << "inline void " << name << "(const uint64_t* inputs, uint64_t* outputs, size_t words)\n"
+       << "{\n"
+       << "    for (size_t k = 0; k < words; k++)\n"
+       << "    {\n"
+       << "        uint64_t in[" << nInputs << "], out[" << nOutputs << "];\n"
+       << "        for (size_t i = 0; i < " << nInputs << "; i++) in[i] = inputs[i * words + k];\n"
+       << "        " << name << "(in, out);\n"
+       << "        for (size_t o = 0; o < " << nOutputs << "; o++) outputs[o * words + k] = out[o];\n"
+       << "    }\n"
+       << "}\n";
+    return ss.str();
+}
+
+template<typename Wires>
+std::string exporter::verilog(const BasicSequentialCircuit<Wires>& circuit, const std::string& name)
+{
+    checkName(name);
+    const std::vector<bool> live = liveWires(circuit);
+    const uint16_t nInputs  = circuit.layers.front().gates.size();
+    const uint16_t nOutputs = circuit.layers.back().gates.size();
+    auto operand = [&](unsigned wire)
+    {
+        return wire < nInputs ? "in[" + std::to_string(wire) + "]" : "w" + std::to_string(wire);
+    };
+
+    std::stringstream ss;
+    ss << "// generated by the sequential logic solver, " << nInputs << " inputs and " << nOutputs << " outputs\n"
+       << "module " << name << " (\n"
+       << "    input  wire [" << nInputs - 1 << ":0] in,\n"
+       << "    output wire [" << nOutputs - 1 << ":0] out\n"
+       << ");\n";
+
+    for (uint8_t l = 1; l < circuit.layers.size() - 1; l++)
+        for (uint8_t g = 0; g < circuit.layers[l].gates.size(); g++)
+        {
+            const uint16_t wire = circuit.layers[l].gateOffset + g;
+            if (live[wire])
+                ss << "    wire " << operand(wire) << " = " << expression(circuit.layers[l].gates[g], operand) << ";\n";
+        }
+
+    for (uint16_t o = 0; o < nOutputs; o++)
+        ss << "    assign out[" << o << "] = " << expression(circuit.layers.back().gates[o], operand) << ";\n";
+
+    ss << "endmodule\n";
+    return ss.str();
+}
+
+
+
+
+// columns as a C array initializer of hex words
+static void printColumns(std::ostream& out, const char* name, const std::vector<uint64_t>& columns, uint64_t words)
+{
+    out << "static const uint64_t " << name << "[" << columns.size() << "] = {";
+    for (uint64_t i = 0; i < columns.size(); i++)
+        out << (i % words ? " " : "\n    ") << "0x" << std::hex << std::setw(16) << std::setfill('0') << columns[i] << "ull,";
+    out << std::dec << std::setfill(' ') << "\n};\n";
+}
+
+template<typename Wires>
+std::string exporter::harness(
+    const BasicSequentialCircuit<Wires>& circuit,
+    const BasicTruthTable<Wires>& truthTable,
+    const std::string& name
+) {
+    checkName(name);
+    const uint16_t nInputs  = circuit.layers.front().gates.size();
+    const uint16_t nOutputs = circuit.layers.back().gates.size();
+
+    // columns of the table rows padded to vectors of four words,
+    // padding rows are not cared for
+    const uint64_t rows  = truthTable.entries.size();
+    const uint64_t words = std::max<uint64_t>(4, (rows + 255) / 256 * 4);
+    std::vector<uint64_t> inputs(nInputs * words), targets(nOutputs * words), cares(nOutputs * words), interpreted(nOutputs * words);
+
+    for (uint64_t r = 0; r < rows; r++)
+    {
+        const auto& entry = truthTable.entries[r];
+        const Wires outputBits = circuit.evaluate(entry.inputBits);
+        const uint64_t word = r / 64;
+        const uint64_t bit  = 1ul << (r % 64);
+
+        for (uint16_t i = 0; i < nInputs; i++)
+            if (testWire(entry.inputBits, i)) inputs[i * words + word] |= bit;
+
+        for (uint16_t o = 0; o < nOutputs; o++)
+        {
+            if (testWire(entry.outputBits, o))    targets[o * words + word]     |= bit;
+            if (!testWire(entry.dontCareBits, o)) cares[o * words + word]       |= bit;
+            if (testWire(outputBits, o))          interpreted[o * words + word] |= bit;
+        }
+    }
+
+    std::stringstream ss;
+    ss << "// generated by the sequential logic solver, checks " << name << ".h against\n"
+       << "// the truth table and the interpreted circuit on all table rows\n"
+       << "#include \"" << name << ".h\"\n"
+       << "#include <stdio.h>\n"
+       << "\n"
+       << "#define ROWS    " << rows << "ull\n"
+       << "#define WORDS   " << words << "\n"
+       << "#define INPUTS  " << nInputs << "\n"
+       << "#define OUTPUTS " << nOutputs << "\n"
+       << "\n";
+
+    printColumns(ss, "inputs", inputs, words);
+    printColumns(ss, "targets", targets, words);
+    printColumns(ss, "cares", cares, words);
+    printColumns(ss, "interpreted", interpreted, words);
+
+    ss << "\n"
+       << "// four words of 256 rows\n"
+       << "typedef uint64_t Vector __attribute__((vector_size(32)));\n"
+       << "\n"
+       << "// output bits differing from the cared table outputs or the circuit\n"
+       << "static unsigned long differences(const uint64_t* outputs)\n"
+       << "{\n"
+       << "    unsigned long count = 0;\n"
+       << "    for (int i = 0; i < OUTPUTS * WORDS; i++)\n"
+       << "    {\n"
+       << "        const unsigned long long first = i % WORDS * 64ull;\n"
+       << "        const uint64_t valid = first + 64 <= ROWS ? ~0ull : first < ROWS ? ~(~0ull << ROWS % 64) : 0;\n"
+       << "        count += __builtin_popcountll((outputs[i] ^ targets[i]) & cares[i]);\n"
+       << "        count += __builtin_popcountll((outputs[i] ^ interpreted[i]) & valid);\n"
+       << "    }\n"
+       << "    return count;\n"
+       << "}\n"
+       << "\n"
+       << "int main()\n"
+       << "{\n"
+       << "    static uint64_t outputs[OUTPUTS * WORDS];\n"
+       << "\n"
+       << "    " << name << "(inputs, outputs, WORDS);\n"
+       << "    const unsigned long scalar = differences(outputs);\n"
+       << "\n"
+       << "    for (int k = 0; k < WORDS; k += 4)\n"
+       << "    {\n"
+       << "        Vector in[INPUTS], out[OUTPUTS];\n"
+       << "        for (int i = 0; i < INPUTS; i++)\n"
+       << "            for (int lane = 0; lane < 4; lane++) in[i][lane] = inputs[i * WORDS + k + lane];\n"
+       << "        " << name << "(in, out);\n"
+       << "        for (int o = 0; o < OUTPUTS; o++)\n"
+       << "            for (int lane = 0; lane < 4; lane++) outputs[o * WORDS + k + lane] = out[o][lane];\n"
+       << "    }\n"
+       << "    const unsigned long vector = differences(outputs);\n"
+       << "\n"
+       << "    printf(\"%s " << name << ": %llu rows, %lu differing bits with 64 rows per word, %lu with 256\\n\",\n"
+       << "           scalar or vector ? \"FAILED\" : \"passed\", ROWS, scalar, vector);\n"
+       << "    return scalar or vector;\n"
+       << "}\n";
+    return ss.str();
+}
+
+
+
+
+template<typename Wires>
+void exporter::write(
+    const BasicSequentialCircuit<Wires>& circuit,
+    const BasicTruthTable<Wires>& truthTable,
+    const std::string& directory,
+    const std::string& name
+) {
+    const std::pair<std::string, std::string> files[] = {
+        { name + ".h",         cppHeader(circuit, name) },
+        { name + ".v",         verilog(circuit, name) },
+        { name + "_check.cpp", harness(circuit, truthTable, name) }
+    };
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+
+    for (auto& [file, content] : files)
+    {
+        const std::string filename = (std::filesystem::path(directory) / file).string();
+        std::ofstream out(filename);
+        if (!out.is_open() or !(out << content).flush())
+            throw std::runtime_error("Cannot write export " + filename + ".");
+    }
+}
+
+
+
+
+#define INSTANTIATE(Wires) \
+    template std::string exporter::cppHeader(const BasicSequentialCircuit<Wires>&, const std::string&); \
+    template std::string exporter::verilog(const BasicSequentialCircuit<Wires>&, const std::string&); \
+    template std::string exporter::harness(const BasicSequentialCircuit<Wires>&, const BasicTruthTable<Wires>&, const std::string&); \
+    template void exporter::write(const BasicSequentialCircuit<Wires>&, const BasicTruthTable<Wires>&, const std::string&, const std::string&);
+LOGIC_FOR_EACH_WIRES(INSTANTIATE)
+#undef INSTANTIATE
@@ -0,0 +1,355 @@
+#include "kernels.h"
+#include <algorithm>
+#include <array>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+using namespace logic;
+using Mode = SequentialCircuit::Gate::Mode;
+
+
+
+
+// scalar kernels
+
+static void gateActivationsScalar(
+    const uint64_t* activations,
+    uint64_t words,
+    uint64_t inputMask,
+    Mode mode,
+    uint64_t* column
+) {
+    const uint64_t invert = -(uint64_t(mode) >> 2);
+    for (uint64_t w = 0; w < words; w++)
+    {
+        uint64_t mask = inputMask;
+        uint64_t activation = activations[__builtin_ctzll(mask) * words + w];
+        mask &= mask - 1;
+
+        switch (uint8_t(mode) & 3)
+        {
+            case uint8_t(Mode::AND): for (; mask; mask &= mask - 1) activation &= activations[__builtin_ctzll(mask) * words + w]; break;
+            case uint8_t(Mode::OR):  for (; mask; mask &= mask - 1) activation |= activations[__builtin_ctzll(mask) * words + w]; break;
+            case uint8_t(Mode::XOR): for (; mask; mask &= mask - 1) activation ^= activations[__builtin_ctzll(mask) * words + w]; break;
+        }
+
+        column[w] = activation ^ invert;
+    }
+}
+
+// failing mode bits of the mode differences in cared rows
+static inline uint8_t modeFailures(uint64_t andDiff, uint64_t orDiff, uint64_t xorDiff, uint64_t care)
+{
+    using enum Mode;
+    return (uint8_t(andDiff != 0)    << uint8_t(AND))  |
+           (uint8_t(orDiff  != 0)    << uint8_t(OR))   |
+           (uint8_t(xorDiff != 0)    << uint8_t(XOR))  |
+           (uint8_t(andDiff != care) << uint8_t(NAND)) |
+           (uint8_t(orDiff  != care) << uint8_t(NOR))  |
+           (uint8_t(xorDiff != care) << uint8_t(XNOR));
+}
+
+static uint8_t modeOptionsScalarFrom(
+    uint64_t begin,
+    const uint64_t* activations,
+    uint64_t words,
+    uint64_t inputMask,
+    const uint64_t* target,
+    const uint64_t* dontCare,
+    uint8_t options
+) {
+    for (uint64_t w = begin; w < words and options; w++)
+    {
+        uint64_t andActivation = ~0ul, orActivation = 0, xorActivation = 0;
+        for (uint64_t mask = inputMask; mask; mask &= mask - 1)
+        {
+            uint64_t activation = activations[__builtin_ctzll(mask) * words + w];
+            andActivation &= activation;
+            orActivation  |= activation;
+            xorActivation ^= activation;
+        }
+
+        const uint64_t care = ~dontCare[w];
+        options &= ~modeFailures(
+            (andActivation ^ target[w]) & care,
+            (orActivation  ^ target[w]) & care,
+            (xorActivation ^ target[w]) & care,
+            care);
+    }
+    return options;
+}
+
+static uint8_t modeOptionsScalar(
+    const uint64_t* activations,
+    uint64_t words,
+    uint64_t inputMask,
+    const uint64_t* target,
+    const uint64_t* dontCare,
+    uint8_t options
+) {
+    return modeOptionsScalarFrom(0, activations, words, inputMask, target, dontCare, options);
+}
+
+
+
+
+#if defined(__x86_64__)
+
+// avx2 kernels, 4 words per instruction
+
+__attribute__((target("avx2")))
+static void gateActivationsAVX2(
+    const uint64_t* activations,
+    uint64_t words,
+    uint64_t inputMask,
+    Mode mode,
+    uint64_t* column
+) {
+    const __m256i invert = _mm256_set1_epi64x(-(int64_t(mode) >> 2));
+    uint64_t w = 0;
+    for (; w + 4 <= words; w += 4)
+    {
+        uint64_t mask = inputMask;
+        __m256i activation = _mm256_loadu_si256((const __m256i*)(activations + __builtin_ctzll(mask) * words + w));
+        mask &= mask - 1;
+
+        #define LOAD _mm256_loadu_si256((const __m256i*)(activations + __builtin_ctzll(mask) * words + w))
+        switch (uint8_t(mode) & 3)
+        {
+            case uint8_t(Mode::AND): for (; mask; mask &= mask - 1) activation = _mm256_and_si256(activation, LOAD); break;
+            case uint8_t(Mode::OR):  for (; mask; mask &= mask - 1) activation = _mm256_or_si256(activation, LOAD);  break;
+            case uint8_t(Mode::XOR): for (; mask; mask &= mask - 1) activation = _mm256_xor_si256(activation, LOAD); break;
+        }
+        #undef LOAD
+
+        _mm256_storeu_si256((__m256i*)(column + w), _mm256_xor_si256(activation, invert));
+    }
+
+    // remaining words
+    if (w < words)
+    {
+        uint64_t tail[4];
+        for (uint64_t i = w; i < words; i++)
+        {
+            uint64_t mask = inputMask;
+            uint64_t activation = activations[__builtin_ctzll(mask) * words + i];
+            mask &= mask - 1;
+            for (; mask; mask &= mask - 1)
+            {
+                uint64_t other = activations[__builtin_ctzll(mask) * words + i];
+                switch (uint8_t(mode) & 3)
+                {
+                    case uint8_t(Mode::AND): activation &= other; break;
+                    case uint8_t(Mode::OR):  activation |= other; break;
+                    case uint8_t(Mode::XOR): activation ^= other; break;
+                }
+            }
+            tail[i - w] = activation ^ -(uint64_t(mode) >> 2);
+        }
+        std::copy(tail, tail + (words - w), column + w);
+    }
+}
+
+__attribute__((target("avx2")))
+static uint8_t modeOptionsAVX2(
+    const uint64_t* activations,
+    uint64_t words,
+    uint64_t inputMask,
+    const uint64_t* target,
+    const uint64_t* dontCare,
+    uint8_t options
+) {
+    const __m256i ones = _mm256_set1_epi64x(-1);
+    uint64_t w = 0;
+    for (; w + 4 <= words and options; w += 4)
+    {
+        __m256i andActivation = ones, orActivation = _mm256_setzero_si256(), xorActivation = orActivation;
+        for (uint64_t mask = inputMask; mask; mask &= mask - 1)
+        {
+            __m256i activation = _mm256_loadu_si256((const __m256i*)(activations + __builtin_ctzll(mask) * words + w));
+            andActivation = _mm256_and_si256(andActivation, activation);
+            orActivation  = _mm256_or_si256(orActivation, activation);
+            xorActivation = _mm256_xor_si256(xorActivation, activation);
+        }
+
+        const __m256i t    = _mm256_loadu_si256((const __m256i*)(target + w));
+        const __m256i care = _mm256_andnot_si256(_mm256_loadu_si256((const __m256i*)(dontCare + w)), ones);
+        const __m256i andDiff = _mm256_and_si256(_mm256_xor_si256(andActivation, t), care);
+        const __m256i orDiff  = _mm256_and_si256(_mm256_xor_si256(orActivation, t), care);
+        const __m256i xorDiff = _mm256_and_si256(_mm256_xor_si256(xorActivation, t), care);
+
+        using enum Mode;
+        options &= ~(
+            (uint8_t(!_mm256_testz_si256(andDiff, andDiff)) << uint8_t(AND)) |
+            (uint8_t(!_mm256_testz_si256(orDiff, orDiff))   << uint8_t(OR))  |
+            (uint8_t(!_mm256_testz_si256(xorDiff, xorDiff)) << uint8_t(XOR)) |
+            (uint8_t(!_mm256_testc_si256(andDiff, care))    << uint8_t(NAND)) |
+            (uint8_t(!_mm256_testc_si256(orDiff, care))     << uint8_t(NOR))  |
+            (uint8_t(!_mm256_testc_si256(xorDiff, care))    << uint8_t(XNOR)));
+    }
+    return modeOptionsScalarFrom(w, activations, words, inputMask, target, dontCare, options);
+}
+
+
+
+
+// avx-512 kernels, 8 words per instruction
+
+__attribute__((target("avx512f")))
+static void gateActivationsAVX512(
+    const uint64_t* activations,
+    uint64_t words,
+    uint64_t inputMask,
+    Mode mode,
+    uint64_t* column
+) {
+    const __m512i invert = _mm512_set1_epi64(-(int64_t(mode) >> 2));
+    for (uint64_t w = 0; w < words; w += 8)
+    {
+        // masked loads and stores for the remaining words
+        const __mmask8 lanes = words - w >= 8 ? 0xff : (1u << (words - w)) - 1;
+
+        uint64_t mask = inputMask;
+        __m512i activation = _mm512_maskz_loadu_epi64(lanes, activations + __builtin_ctzll(mask) * words + w);
+        mask &= mask - 1;
+
+        #define LOAD _mm512_maskz_loadu_epi64(lanes, activations + __builtin_ctzll(mask) * words + w)
+        switch (uint8_t(mode) & 3)
+        {
+            case uint8_t(Mode::AND): for (; mask; mask &= mask - 1) activation = _mm512_and_si512(activation, LOAD); break;
+            case uint8_t(Mode::OR):  for (; mask; mask &= mask - 1) activation = _mm512_or_si512(activation, LOAD);  break;
+            case uint8_t(Mode::XOR): for (; mask; mask &= mask - 1) activation = _mm512_xor_si512(activation, LOAD); break;
+        }
+        #undef LOAD
+
+        _mm512_mask_storeu_epi64(column + w, lanes, _mm512_xor_si512(activation, invert));
+    }
+}
+
+__attribute__((target("avx512f")))
+static uint8_t modeOptionsAVX512(
+    const uint64_t* activations,
+    uint64_t words,
+    uint64_t inputMask,
+    const uint64_t* target,
+    const uint64_t* dontCare,
+    uint8_t options
+) {
+    const __m512i ones = _mm512_set1_epi64(-1);
+    for (uint64_t w = 0; w < words and options; w += 8)
+    {
+        // rows of lanes past the last word are not cared for
+        const __mmask8 lanes = words - w >= 8 ? 0xff : (1u << (words - w)) - 1;
+
+        __m512i andActivation = ones, orActivation = _mm512_setzero_si512(), xorActivation = orActivation;
+        for (uint64_t mask = inputMask; mask; mask &= mask - 1)
+        {
+            __m512i activation = _mm512_maskz_loadu_epi64(lanes, activations + __builtin_ctzll(mask) * words + w);
+            andActivation = _mm512_and_si512(andActivation, activation);
+            orActivation  = _mm512_or_si512(orActivation, activation);
+            xorActivation = _mm512_xor_si512(xorActivation, activation);
+        }
+
+        const __m512i t    = _mm512_maskz_loadu_epi64(lanes, target + w);
+        const __m512i care = _mm512_maskz_loadu_epi64(lanes, dontCare + w) ^ _mm512_maskz_mov_epi64(lanes, ones);
+        const __m512i andDiff = _mm512_and_si512(_mm512_xor_si512(andActivation, t), care);
+        const __m512i orDiff  = _mm512_and_si512(_mm512_xor_si512(orActivation, t), care);
+        const __m512i xorDiff = _mm512_and_si512(_mm512_xor_si512(xorActivation, t), care);
+
+        using enum Mode;
+        options &= ~(
+            (uint8_t(_mm512_test_epi64_mask(andDiff, andDiff) != 0)                      << uint8_t(AND)) |
+            (uint8_t(_mm512_test_epi64_mask(orDiff, orDiff) != 0)                        << uint8_t(OR))  |
+            (uint8_t(_mm512_test_epi64_mask(xorDiff, xorDiff) != 0)                      << uint8_t(XOR)) |
+            (uint8_t(_mm512_cmpneq_epi64_mask(andDiff, care) != 0)                       << uint8_t(NAND)) |
+            (uint8_t(_mm512_cmpneq_epi64_mask(orDiff, care) != 0)                        << uint8_t(NOR))  |
+            (uint8_t(_mm512_cmpneq_epi64_mask(xorDiff, care) != 0)                       << uint8_t(XNOR)));
+    }
+    return options;
+}
+
+#endif
+
+
+
+
+static const kernels::Kernels scalarKernels = { kernels::Level::SCALAR, 1, gateActivationsScalar, modeOptionsScalar };
+#if defined(__x86_64__)
+static const kernels::Kernels avx2Kernels   = { kernels::Level::AVX2,   4, gateActivationsAVX2,   modeOptionsAVX2 };
+static const kernels::Kernels avx512Kernels = { kernels::Level::AVX512, 8, gateActivationsAVX512, modeOptionsAVX512 };
+#endif
+
+
+kernels::Level kernels::supported()
+{
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return Level::AVX512;
+    if (__builtin_cpu_supports("avx2"))    return Level::AVX2;
+#endif
+    return Level::SCALAR;
+}
+
+const kernels::Kernels& kernels::get(Level level)
+{
+    level = std::min(level, supported());
+#if defined(__x86_64__)
+    if (level == Level::AVX512) return avx512Kernels;
+    if (level == Level::AVX2)   return avx2Kernels;
+#endif
+    return scalarKernels;
+}
+
+const kernels::Kernels& kernels::active()
+{
+    static const Kernels& kernels = get(supported());
+    return kernels;
+}
+
+
+
+
+bool kernels::selfTest(const TruthTable& truthTable)
+{
+    const uint8_t nInputs  = std::max<uint8_t>(1, truthTable.inputWidth());
+    const uint8_t nOutputs = std::max<uint8_t>(1, truthTable.outputWidth());
+
+    // repeat the table rows to cover full vectors and remaining words
+    TruthTable table;
+    for (uint64_t r = 0; table.entries.size() < 64 * 19 + 5 and !truthTable.entries.empty(); r++)
+        table.entries.push_back(truthTable.entries[r % truthTable.entries.size()]);
+
+    bool passed = true;
+    for (const TruthTable* tt : std::array<const TruthTable*, 2>{ &truthTable, &table })
+    {
+        SequentialCircuit circuit;
+        circuit.layers.resize(2);
+        circuit.layers[0].gates.resize(nInputs, { 0, Mode::IN });
+        circuit.layers[1].gateOffset = nInputs;
+        circuit.layers[1].gates.resize(nOutputs);
+        ActivationTruthTable att = computeActivationTruthTable(circuit, *tt);
+
+        std::vector<uint64_t> expected(att.words), column(att.words);
+        for (Level level = Level::AVX2; level <= supported(); level = Level(uint8_t(level) + 1))
+        {
+            const Kernels& k = get(level);
+            for (uint64_t mask = 1; mask < 1ul << nInputs; mask++)
+            {
+                for (Mode mode : { Mode::AND, Mode::OR, Mode::XOR, Mode::NAND, Mode::NOR, Mode::XNOR })
+                {
+                    scalarKernels.gateActivations(att.activations.data(), att.words, mask, mode, expected.data());
+                    k.gateActivations(att.activations.data(), att.words, mask, mode, column.data());
+                    passed = passed and expected == column;
+                }
+
+                for (uint8_t o = 0; o < nOutputs; o++)
+                    passed = passed and
+                        scalarKernels.modeOptions(att.activations.data(), att.words, mask, att.output(o), att.dontCare(o), 0xee) ==
+                        k.modeOptions(att.activations.data(), att.words, mask, att.output(o), att.dontCare(o), 0xee);
+            }
+        }
+    }
+    return passed;
+}
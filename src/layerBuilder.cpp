@@ -0,0 +1,194 @@
+#include "sequentialCircuit.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace logic;
+
+
+
+
+static uint64_t checkedAdd(uint64_t a, uint64_t b)
+{
+    uint64_t c;
+    if (__builtin_add_overflow(a, b, &c))
+        throw std::overflow_error("Layer combinations exceed the 64 bit index range.");
+    return c;
+}
+
+static uint64_t checkedMul(uint64_t a, uint64_t b)
+{
+    uint64_t c;
+    if (__builtin_mul_overflow(a, b, &c))
+        throw std::overflow_error("Layer combinations exceed the 64 bit index range.");
+    return c;
+}
+
+
+
+
+LayerBuilder::LayerBuilder(
+    uint8_t size,
+    uint16_t inputOffset,
+    uint16_t gateOffset,
+    const std::vector<GateMode>& modes,
+    bool balanced
+) :
+    size(size),
+    inputOffset(inputOffset),
+    gateOffset(gateOffset),
+    modes(modes),
+    gateCons(0),
+    combinations(0)
+{
+    // connections are enumerated as masks of the visible wires
+    if (gateOffset - inputOffset >= 64)
+        throw std::overflow_error("Layer connections exceed the 64 bit index range.");
+    gateCons = (1ul << (gateOffset - inputOffset)) - 1;
+
+    // create layer gate mode combinations
+
+    for (auto& modeCombo : uniqueCombinationsOI(size, modes.size()))
+    {
+        ModeCombo combo;
+        combo.first = combinations;
+        combo.combinations = 1;
+
+        // optimize connections for gates of the same mode,
+        // each group of same mode gates takes a combination
+        // of distinct connections
+        uint8_t positions = 1;
+        for (int i = 0; i < modeCombo.size(); i++)
+        {
+            if (i == modeCombo.size() - 1 or modeCombo[i] != modeCombo[i+1])
+            {
+                Group group;
+                group.mode = modeCombo[i];
+                group.positions = positions;
+
+                // remove redundant single-input connections, matching
+                // the connection index 1 for the filtered modes
+                if (balanced and modes.size() > 1 and (uint8_t)modes[1] < 4)
+                    group.filtered = group.mode < 4 and group.mode != (uint64_t)modes.front();
+                else
+                    group.filtered = group.mode < 4 or
+                                     group.mode > 4 and group.mode != (uint64_t)modes.back();
+                group.filtered = group.filtered and gateCons > 1;
+
+                group.combinations = binomial(gateCons - group.filtered, positions);
+                if (group.combinations == UINT64_MAX)
+                    throw std::overflow_error("Layer combinations exceed the 64 bit index range.");
+
+                combo.combinations = checkedMul(combo.combinations, group.combinations);
+                combo.groups.push_back(group);
+                positions = 0;
+            }
+            positions++;
+        }
+
+        if (combo.combinations == 0) continue;
+
+        combinations = checkedAdd(combinations, combo.combinations);
+        modeCombos.push_back(combo);
+    }
+}
+
+
+
+
+template<typename Wires>
+void LayerBuilder::unrank(uint64_t index, BasicLayer<Wires>& layer) const
+{
+    layer.inputOffset = inputOffset;
+    layer.gateOffset = gateOffset;
+    layer.gates.resize(size);
+    unrank(index, layer.gates.data());
+}
+
+template<typename Wires>
+void LayerBuilder::unrank(uint64_t index, BasicGate<Wires>* gates) const
+{
+    if (selected)
+        index = (*selection)[index];
+
+    // find mode combination containing the index
+    auto combo = std::upper_bound(modeCombos.begin(), modeCombos.end(), index,
+        [](uint64_t i, const ModeCombo& c){ return i < c.first; }) - 1;
+    index -= combo->first;
+
+    // last group of gates varies fastest
+    uint8_t position = size;
+    for (auto group = combo->groups.rbegin(); group != combo->groups.rend(); group++)
+    {
+        uint64_t groupIndex = index % group->combinations;
+        index /= group->combinations;
+        position -= group->positions;
+
+        // unrank connection combination in colexicographic order
+        for (uint8_t i = group->positions; i > 0; i--)
+        {
+            // find largest connection c with binomial(c, i) <= groupIndex
+            uint64_t lo = i - 1, hi = gateCons - group->filtered - 1;
+            while (lo < hi)
+            {
+                uint64_t mid = hi - (hi - lo) / 2;
+                if (binomial(mid, i) <= groupIndex) lo = mid;
+                else hi = mid - 1;
+            }
+            groupIndex -= binomial(lo, i);
+
+            uint64_t connection = group->filtered and lo > 0 ? lo + 1 : lo;
+
+            auto& gate = gates[position + i - 1];
+            gate.inputMask = Wires(connection + 1) << inputOffset;
+            gate.mode = modes[group->mode];
+        }
+    }
+}
+
+
+
+
+template<typename Wires>
+uint64_t LayerBuilder::rank(const BasicLayer<Wires>& layer) const
+{
+    // find mode combination of the layer gates
+    auto combo = std::find_if(modeCombos.begin(), modeCombos.end(),
+        [&](const ModeCombo& c)
+        {
+            uint8_t position = 0;
+            for (auto& group : c.groups)
+                for (uint8_t i = 0; i < group.positions; i++, position++)
+                    if (layer.gates[position].mode != modes[group.mode])
+                        return false;
+            return true;
+        });
+
+    if (combo == modeCombos.end())
+        throw std::invalid_argument("Layer is not enumerated by the layer builder.");
+
+    uint64_t index = 0;
+    uint8_t position = 0;
+    for (auto& group : combo->groups)
+    {
+        uint64_t groupIndex = 0;
+        for (uint8_t i = 0; i < group.positions; i++, position++)
+        {
+            uint64_t connection = lowWord(layer.gates[position].inputMask >> inputOffset) - 1;
+            if (group.filtered and connection > 0) connection--;
+            groupIndex += binomial(connection, i + 1);
+        }
+        index = index * group.combinations + groupIndex;
+    }
+
+    return combo->first + index;
+}
+
+
+
+
+#define INSTANTIATE(Wires) \
+    template void LayerBuilder::unrank(uint64_t, BasicLayer<Wires>&) const; \
+    template void LayerBuilder::unrank(uint64_t, BasicGate<Wires>*) const; \
+    template uint64_t LayerBuilder::rank(const BasicLayer<Wires>&) const;
+LOGIC_FOR_EACH_WIRES(INSTANTIATE)
+#undef INSTANTIATE
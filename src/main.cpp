@@ -1,28 +1,270 @@
 #include "sequentialCircuit.h"
+#include "kernels.h"
+#include "exporter.h"
 #include <iostream>
+#include <filesystem>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
 #include <bitset>
+#include <chrono>
 
 using Mode = logic::SequentialCircuit::Gate::Mode;
 using enum Mode;
+using Engine = logic::SolveOptions::Engine;
 
 
 
 
-int main()
+// compare the vector kernels with the scalar kernels and the specialized
+// output gate constructions with the generic one on all tables
+static int selfTest()
 {
+    static const char* levels[] = { "scalar", "avx2", "avx512" };
+    std::cout << "kernel level: " << levels[uint8_t(logic::kernels::supported())] << "\n";
+
+    // tables are read from the ttables directory of the working directory
+    bool passed = true;
+    try
+    {
+        for (auto& file : std::filesystem::directory_iterator("ttables"))
+        {
+            if (file.path().extension() != ".csv") continue;
+
+            auto table = logic::TruthTable::readCSV(file.path().string());
+            bool tablePassed = logic::kernels::selfTest(table) and logic::selfTestOutputGates(table);
+            std::cout << (tablePassed ? "passed " : "FAILED ") << file.path().string() << "\n";
+            passed = passed and tablePassed;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return passed ? 0 : 1;
+}
+
+
+
+
+static int usage()
+{
+    std::cerr << "usage: main [--selftest] [--stats <file>] [--shard <i>/<n>] [--checkpoint <file>] [--cache <directory>] [--best <k>] [--local <seconds>] [--export <directory>] [--order]\n"
+              << "       main --merge <checkpoint>...\n"
+              << "       main --convert <table> <binary table>\n";
+    return 1;
+}
+
+// write a csv or binary table as binary table
+static int convert(const std::string& from, const std::string& to)
+{
+    try
+    {
+        auto table = logic::TruthTable::read(from);
+        table.writeBinary(to);
+        std::cout << table.entries.size() << " rows written to " << to << "\n";
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+// report the first solution of the checkpoints of all shards
+static int merge(const std::vector<std::string>& files)
+{
+    std::vector<logic::Checkpoint> shards;
+    for (auto& file : files)
+    {
+        auto checkpoint = logic::Checkpoint::read(file);
+        if (!checkpoint)
+        {
+            std::cerr << "cannot read checkpoint " << file << "\n";
+            return 1;
+        }
+        shards.push_back(*checkpoint);
+    }
+
+    try
+    {
+        auto circuit = logic::Checkpoint::merge(shards);
+        if (circuit)
+            std::cout << circuit.value();
+        else
+            std::cout << "no circuit solution found\n";
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+
+
+
+int main(int argc, char** argv)
+{
+    // optional json dump of the search counters at exit
+    const char* statsFile = nullptr;
+    logic::SearchStats stats;
+
+    logic::SolveOptions searchOptions;
+    searchOptions.stats = &stats;
+
+    // number of cheapest circuits to list instead of the first
+    uint64_t best = 0;
+
+    // run only the local search with this time budget if set
+    double local = 0;
+
+    // directory to compile the circuit found to if set
+    const char* exportDirectory = nullptr;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--selftest") == 0)
+            return selfTest();
+        else if (std::strcmp(argv[i], "--merge") == 0)
+            return merge(std::vector<std::string>(argv + i + 1, argv + argc));
+        else if (std::strcmp(argv[i], "--convert") == 0 and i + 2 < argc)
+            return convert(argv[i + 1], argv[i + 2]);
+        else if (std::strcmp(argv[i], "--stats") == 0 and i + 1 < argc)
+            statsFile = argv[++i];
+        else if (std::strcmp(argv[i], "--checkpoint") == 0 and i + 1 < argc)
+            searchOptions.checkpoint = argv[++i];
+        else if (std::strcmp(argv[i], "--cache") == 0 and i + 1 < argc)
+            searchOptions.cache = argv[++i];
+        else if (std::strcmp(argv[i], "--export") == 0 and i + 1 < argc)
+            exportDirectory = argv[++i];
+        else if (std::strcmp(argv[i], "--order") == 0)
+            searchOptions.orderCandidates = true;
+        else if (std::strcmp(argv[i], "--best") == 0 and i + 1 < argc)
+        {
+            if (std::sscanf(argv[++i], "%lu", &best) != 1)
+                return usage();
+        }
+        else if (std::strcmp(argv[i], "--local") == 0 and i + 1 < argc)
+        {
+            if (std::sscanf(argv[++i], "%lf", &local) != 1 or local <= 0)
+                return usage();
+        }
+        else if (std::strcmp(argv[i], "--shard") == 0 and i + 1 < argc)
+        {
+            if (std::sscanf(argv[++i], "%lu/%lu", &searchOptions.shard, &searchOptions.shards) != 2)
+                return usage();
+        }
+        else
+            return usage();
+    }
+
     //std::vector<Mode> modes = { AND, OR, XOR, NAND, NOR, XNOR };
     //auto table = logic::TruthTable::readCSV("ttables/greater_4_add_3.csv");
     //auto circuit = logic::SequentialCircuit::solve({ 4, 4, 4 }, table, modes, false);
     
     std::vector<Mode> modes = { AND, XOR };
-    auto table = logic::TruthTable::readCSV("ttables/4bit_popcount.csv");
-    auto circuit = logic::SequentialCircuit::solve({ 4, 3, 1, 3 }, table, modes, false);
-    //auto circuit = logic::SequentialCircuit::solve({ 4, 6, 3 }, table, modes, false);
-
-    if (circuit)
-        std::cout << circuit.value();
-    else
-        std::cout << "no circuit solution found";
+    logic::TruthTable table;
+    try
+    {
+        table = logic::TruthTable::read("ttables/4bit_popcount.csv");
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    // cheapest circuits by gates and gate inputs
+    if (best)
+    {
+        logic::CostModel cost;
+        cost.input = 1;
+
+        auto start = std::chrono::steady_clock::now();
+        auto circuits = logic::SequentialCircuit::solveBest({ 4, 3, 1, 3 }, table, modes, best, cost, false, searchOptions);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        for (auto& circuit : circuits)
+            std::cout << "cost " << circuit.cost(cost) << " " << circuit;
+        if (circuits.empty())
+            std::cout << "no circuit solution found\n";
+        std::cout << "solved in " << elapsed.count() << "s\n\n";
+
+        if (statsFile)
+            std::ofstream(statsFile) << stats.toJSON();
+        return 0;
+    }
+
+    // best circuit of the local search, exact or not
+    if (local)
+    {
+        searchOptions.localSeconds = local;
+        searchOptions.threads = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        auto result = logic::SequentialCircuit::solveLocal({ 4, 3, 1, 3 }, table, modes, false, searchOptions);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::cout << "mismatches " << result.mismatches << " " << result.circuit;
+        std::cout << "solved in " << elapsed.count() << "s\n\n";
+
+        if (statsFile)
+            std::ofstream(statsFile) << stats.toJSON();
+        return 0;
+    }
+
+    // C++ header, Verilog module and check program of the circuit
+    if (exportDirectory)
+    {
+        auto circuit = logic::SequentialCircuit::solve({ 4, 3, 1, 3 }, table, modes, false, searchOptions);
+        if (!circuit)
+        {
+            std::cout << "no circuit solution found\n";
+            return 1;
+        }
+
+        try
+        {
+            logic::exporter::write(circuit.value(), table, exportDirectory, "popcount");
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+        std::cout << circuit.value() << "exported to " << exportDirectory << "\n";
+        return 0;
+    }
+
+    // only the enumeration is split into shards
+    std::vector<Engine> engines = { Engine::ENUMERATE, Engine::BIDIRECTIONAL, Engine::SAT };
+    if (searchOptions.shards > 1 or !searchOptions.checkpoint.empty())
+        engines.resize(1);
+
+    // compare wall-clock time of the solver engines
+    for (Engine engine : engines)
+    {
+        logic::SolveOptions options = searchOptions;
+        options.engine = engine;
+
+        auto start = std::chrono::steady_clock::now();
+        auto circuit = logic::SequentialCircuit::solve({ 4, 3, 1, 3 }, table, modes, false, options);
+        //auto circuit = logic::SequentialCircuit::solve({ 4, 6, 3 }, table, modes, false, options);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        if (circuit)
+            std::cout << circuit.value();
+        else
+            std::cout << "no circuit solution found\n";
+        std::cout << "solved in " << elapsed.count() << "s\n\n";
+    }
+
+    if (statsFile)
+        std::ofstream(statsFile) << stats.toJSON();
 
     return 0;
 }
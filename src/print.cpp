@@ -6,11 +6,32 @@
 
 
 
+// input masks of up to 64 wires in decimal, wider masks in hex
+static std::ostream& printMask(std::ostream& out, uint64_t mask)
+{
+    return out << std::setw(5) << mask;
+}
+
+template<unsigned Words>
+static std::ostream& printMask(std::ostream& out, const logic::WideWires<Words>& mask)
+{
+    unsigned w = Words - 1;
+    while (w > 0 and !mask.words[w]) w--;
+
+    out << "0x" << std::hex << mask.words[w];
+    while (w-- > 0)
+        out << std::setw(16) << std::setfill('0') << mask.words[w];
+    return out << std::dec << std::setfill(' ');
+}
+
+
+
+
 namespace std
 {
-    std::string to_string(const logic::SequentialCircuit::Gate::Mode& mode)
+    std::string to_string(const logic::GateMode& mode)
     {
-        using enum logic::SequentialCircuit::Gate::Mode;
+        using enum logic::GateMode;
 
         switch (mode)
         {
@@ -25,14 +46,16 @@ namespace std
         return {};
     }
 
-    std::string to_string(const logic::SequentialCircuit::Gate& gate)
+    template<typename Wires>
+    std::string to_string(const logic::BasicGate<Wires>& gate)
     {
         std::stringstream ss;
-        ss << setw(5) << gate.inputMask << "_" << gate.mode;
+        printMask(ss, gate.inputMask) << "_" << gate.mode;
         return ss.str();
     }
 
-    std::string to_string(const logic::SequentialCircuit::Layer& layer)
+    template<typename Wires>
+    std::string to_string(const logic::BasicLayer<Wires>& layer)
     {
         std::stringstream ss;
         ss << "[ ";
@@ -42,7 +65,8 @@ namespace std
         return ss.str();
     }
 
-    std::string to_string(const logic::SequentialCircuit& circuit)
+    template<typename Wires>
+    std::string to_string(const logic::BasicSequentialCircuit<Wires>& circuit)
     {
         std::stringstream ss;
         ss << "circuit:\n";
@@ -52,15 +76,31 @@ namespace std
         return ss.str();
     }
 
-    std::ostream& operator<<(std::ostream& out, const logic::SequentialCircuit::Gate::Mode& mode)
+    std::ostream& operator<<(std::ostream& out, const logic::GateMode& mode)
     { return out << to_string(mode); }
 
-    std::ostream& operator<<(std::ostream& out, const logic::SequentialCircuit::Gate& gate)
+    template<typename Wires>
+    std::ostream& operator<<(std::ostream& out, const logic::BasicGate<Wires>& gate)
     { return out << to_string(gate); }
 
-    std::ostream& operator<<(std::ostream& out, const logic::SequentialCircuit::Layer& layer)
+    template<typename Wires>
+    std::ostream& operator<<(std::ostream& out, const logic::BasicLayer<Wires>& layer)
     { return out << to_string(layer); }
 
-    std::ostream& operator<<(std::ostream& out, const logic::SequentialCircuit& circuit)
+    template<typename Wires>
+    std::ostream& operator<<(std::ostream& out, const logic::BasicSequentialCircuit<Wires>& circuit)
     { return out << to_string(circuit); }
+
+
+
+
+#define INSTANTIATE(Wires) \
+    template std::string to_string(const logic::BasicGate<Wires>&); \
+    template std::string to_string(const logic::BasicLayer<Wires>&); \
+    template std::string to_string(const logic::BasicSequentialCircuit<Wires>&); \
+    template std::ostream& operator<<(std::ostream&, const logic::BasicGate<Wires>&); \
+    template std::ostream& operator<<(std::ostream&, const logic::BasicLayer<Wires>&); \
+    template std::ostream& operator<<(std::ostream&, const logic::BasicSequentialCircuit<Wires>&);
+LOGIC_FOR_EACH_WIRES(INSTANTIATE)
+#undef INSTANTIATE
 };
@@ -0,0 +1,159 @@
+#include "sequentialCircuit.h"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include <cstdio>
+
+using namespace logic;
+
+
+
+
+uint64_t SolutionCache::key(
+    const TruthTable& truthTable,
+    uint16_t outputs,
+    std::vector<GateMode> modes,
+    bool balanced,
+    const SolveOptions& options
+) {
+    TruthTable table = truthTable.compacted(outputs);
+    std::stable_sort(table.entries.begin(), table.entries.end(),
+        [](const TruthTable::Entry& a, const TruthTable::Entry& b){ return a.inputBits < b.inputBits; });
+    std::sort(modes.begin(), modes.end());
+
+    // fnv-1a continued over the outputs, modes, balance and options
+    uint64_t h = (table.hash() ^ outputs) * 0x100000001b3;
+    for (auto mode : modes)
+        h = (h ^ uint8_t(mode)) * 0x100000001b3;
+    h = (h ^ 0xff) * 0x100000001b3;
+    h = (h ^ balanced) * 0x100000001b3;
+
+    h = (h ^ uint8_t(options.engine)) * 0x100000001b3;
+    return (h ^ options.enumerationFlags()) * 0x100000001b3;
+}
+
+static std::string cacheFile(const std::string& directory, uint64_t key)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016lx.cache", key);
+    return (std::filesystem::path(directory) / name).string();
+}
+
+
+
+
+// one result per record, infeasible or found with the layer sizes,
+// a solution follows as layer lines of input offset, gate offset,
+// then input mask and mode per gate
+SolutionCache::Result SolutionCache::lookup(
+    const TruthTable& truthTable,
+    const std::vector<uint8_t>& layerSizes,
+    const std::vector<GateMode>& modes,
+    bool balanced,
+    const SolveOptions& options
+) const {
+    const std::string filename = cacheFile(directory, key(truthTable, layerSizes.back(), modes, balanced, options));
+    std::ifstream file(filename);
+    if (!file.is_open()) return {};
+
+    // a solution must satisfy the table, which guards against
+    // results of other problems of the same key
+    auto satisfies = [&](const SequentialCircuit& circuit)
+    {
+        if (circuit.layers.size() != layerSizes.size()) return false;
+        for (uint8_t l = 0; l < layerSizes.size(); l++)
+            if (circuit.layers[l].gates.size() != layerSizes[l]) return false;
+
+        for (auto& entry : truthTable.entries)
+            if ((circuit.evaluate(entry.inputBits) ^ entry.outputBits) & ~entry.dontCareBits)
+                return false;
+        return true;
+    };
+
+    Result result;
+    std::optional<SequentialCircuit> solution;
+    std::vector<uint8_t> sizes;
+    std::string line, key;
+
+    auto record = [&]()
+    {
+        if (solution and sizes == layerSizes and satisfies(*solution))
+            result = { true, solution };
+        solution.reset();
+    };
+
+    while (std::getline(file, line) and !result.cached)
+    {
+        std::istringstream values(line);
+        values >> key;
+
+        uint64_t value;
+        if (key == "infeasible" or key == "found")
+        {
+            record();
+            sizes.clear();
+            while (values >> value) sizes.push_back(value);
+            if (sizes.size() < 2)
+                throw std::runtime_error("Invalid solution cache " + filename + ": " + line);
+
+            if (key == "found")
+                solution.emplace();
+            else if (sizes == layerSizes)
+                result.cached = true;
+        }
+        else if (key == "layer" and solution)
+        {
+            SequentialCircuit::Layer layer;
+            values >> value; layer.inputOffset = value;
+            values >> value; layer.gateOffset = value;
+
+            uint64_t mask, mode;
+            while (values >> mask >> mode)
+                layer.gates.push_back({ mask, (SequentialCircuit::Gate::Mode)mode });
+            solution->layers.push_back(layer);
+        }
+        else
+            throw std::runtime_error("Invalid solution cache " + filename + ": " + line);
+
+        if (values.fail() and !values.eof())
+            throw std::runtime_error("Invalid solution cache " + filename + ": " + line);
+    }
+    record();
+
+    return result;
+}
+
+void SolutionCache::store(
+    const TruthTable& truthTable,
+    const std::vector<uint8_t>& layerSizes,
+    const std::vector<GateMode>& modes,
+    bool balanced,
+    const SolveOptions& options,
+    const std::optional<SequentialCircuit>& solution
+) const {
+    std::ostringstream record;
+    record << (solution ? "found" : "infeasible");
+    for (uint8_t size : layerSizes) record << " " << (int)size;
+    record << "\n";
+
+    if (solution)
+        for (auto& layer : solution->layers)
+        {
+            record << "layer " << (int)layer.inputOffset << " " << (int)layer.gateOffset;
+            for (auto& gate : layer.gates)
+                record << " " << gate.inputMask << " " << (int)gate.mode;
+            record << "\n";
+        }
+
+    // records are appended in a single write, concurrent
+    // runs of the same problem append to the same file
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+
+    const std::string filename = cacheFile(directory, key(truthTable, layerSizes.back(), modes, balanced, options));
+    std::ofstream file(filename, std::ios::app);
+    if (!file.is_open() or !(file << record.str()).flush())
+        throw std::runtime_error("Cannot write solution cache " + filename + ".");
+}
@@ -1,331 +1,2318 @@
 #include "sequentialCircuit.h"
+#include "kernels.h"
 #include <iostream>
 #include <algorithm>
 #include <numeric>
 #include <math.h>
 #include <bitset>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <deque>
+#include <chrono>
+#include <stdexcept>
+#include <unordered_map>
+#include <functional>
+#include <array>
+#include <utility>
 
 using namespace logic;
 
 
 
 
-struct LayerBuilder
+// range of circuit combination indices [begin, end)
+struct SearchChunk
 {
-    uint8_t size;
-    uint8_t inputOffset;
-    uint8_t gateOffset;
-    std::vector<SequentialCircuit::Layer> combinations;
+    uint64_t begin;
+    uint64_t end;
 };
 
+struct WorkQueue
+{
+    std::mutex mutex;
+    std::deque<SearchChunk> chunks;
+};
+
+
+// take the next chunk from the front of the thread's own queue,
+// or steal from the back of another thread's queue
+static bool popChunk(std::vector<WorkQueue>& queues, unsigned thread, SearchChunk& chunk)
+{
+    for (unsigned i = 0; i < queues.size(); i++)
+    {
+        WorkQueue& queue = queues[(thread + i) % queues.size()];
+        std::lock_guard lock(queue.mutex);
+        
+        if (queue.chunks.empty()) continue;
+
+        if (i == 0)
+        {
+            chunk = queue.chunks.front();
+            queue.chunks.pop_front();
+        }
+        else
+        {
+            chunk = queue.chunks.back();
+            queue.chunks.pop_back();
+        }
+        return true;
+    }
+    return false;
+}
+
+
+// set of layer activation signatures of fixed length, 
+// stored contiguously in an open addressing hash table
+struct SignatureSet
+{
+    uint64_t length = 0;
+    uint64_t count  = 0;
+    std::vector<uint64_t> signatures;
+    std::vector<uint64_t> slots;    // signature index + 1, 0 if empty
+
+    static uint64_t hash(const uint64_t* signature, uint64_t length)
+    {
+        uint64_t h = length;
+        for (uint64_t i = 0; i < length; i++)
+        {
+            h ^= signature[i] + 0x9e3779b97f4a7c15ul + (h << 6) + (h >> 2);
+            h *= 0xbf58476d1ce4e5b9ul;
+        }
+        return h ^ (h >> 31);
+    }
+
+    void clear()
+    {
+        if (count == 0) return;
+        std::fill(slots.begin(), slots.end(), 0);
+        signatures.clear();
+        count = 0;
+    }
+
+    // index of signature, or count if not contained
+    uint64_t find(const uint64_t* signature, uint64_t h) const
+    {
+        if (slots.empty()) return count;
+        for (uint64_t i = h & (slots.size() - 1); slots[i]; i = (i + 1) & (slots.size() - 1))
+            if (std::equal(signature, signature + length, signatures.data() + (slots[i] - 1) * length))
+                return slots[i] - 1;
+        return count;
+    }
+
+    bool contains(const uint64_t* signature, uint64_t h) const
+    {
+        return find(signature, h) != count;
+    }
+
+    // insert signature, return its index
+    uint64_t insert(const uint64_t* signature, uint64_t h)
+    {
+        if (2 * (count + 1) > slots.size())
+        {
+            // grow table and reinsert signatures
+            slots.assign(std::max<uint64_t>(64, 2 * slots.size()), 0);
+            for (uint64_t s = 0; s < count; s++)
+            {
+                uint64_t i = hash(signatures.data() + s * length, length) & (slots.size() - 1);
+                while (slots[i]) i = (i + 1) & (slots.size() - 1);
+                slots[i] = s + 1;
+            }
+        }
+
+        uint64_t i = h & (slots.size() - 1);
+        while (slots[i]) i = (i + 1) & (slots.size() - 1);
+        signatures.insert(signatures.end(), signature, signature + length);
+        slots[i] = ++count;
+        return count - 1;
+    }
+};
+
+// hash of the words of a wire state, for maps keyed by wire states
+struct WiresHash
+{
+    uint64_t operator()(uint64_t wires) const { return SignatureSet::hash(&wires, 1); }
+
+    template<unsigned Words>
+    uint64_t operator()(const WideWires<Words>& wires) const { return SignatureSet::hash(wires.words, Words); }
+};
+
+
+// output gates of the output layer for a mode mask, instantiated
+// for a compile-time mode set which is dispatched to once
+template<typename Wires>
+using OutputGatesKernel = bool (*)(
+    BasicGate<Wires>* gates,
+    uint8_t size,
+    uint16_t inputOffset,
+    uint16_t gateOffset,
+    const ActivationTruthTable& activationTruthTable,
+    uint8_t modes,
+    SearchStats* stats,
+    const CostModel* cost,
+    KillerRows* killers);
+
+template<typename Wires>
+static OutputGatesKernel<Wires> outputGatesKernel(uint8_t modes);
+
+static uint8_t modeMask(const std::vector<GateMode>& modes);
+
+
+// per thread checks in front of tryConstructOutputLayer
+// -> reject candidates where rows with equal activations of all
+//    wires visible to the output layer require different outputs
+// -> cache output gates found for each output position by the 
+//    activations visible to the output layer
+template<typename Wires>
+struct OutputLayerCheck
+{
+    using Gate = BasicGate<Wires>;
+    using FlatCircuit = BasicFlatCircuit<Wires>;
+
+    static constexpr uint64_t cacheLimit = 1ul << 16;
+
+    // only cache when the visible wires do not include all preceding
+    // layers and constructing the output layer is expensive
+    static constexpr uint64_t cacheMinCost = 1ul << 10;
+    bool cached;
+
+    // row-major target output and care bits
+    std::vector<uint64_t> rowOutputs;
+    std::vector<uint64_t> rowCares;
+
+    // projection of rows onto visible wires, with row index
+    std::vector<std::pair<uint64_t, uint64_t>> projections;
+
+    // target output and care bits accumulated per projection
+    static constexpr uint8_t directLimit = 12;
+    std::vector<uint64_t> classOnes;
+    std::vector<uint64_t> classZeros;
+
+    // visible activations with output gates found for them,
+    // an input mask of 0 marks a position without a gate
+    SignatureSet cache;
+    std::vector<Gate> cachedGates;
+    std::vector<uint64_t> signature;
+
+    // rows rejecting recent output gates, checked first
+    KillerRows killers;
+
+    SearchStats& stats;
+    const CostModel* cost;
+
+    // output gate construction specialized for the modes
+    uint8_t modes;
+    OutputGatesKernel<Wires> constructGates;
+
+    OutputLayerCheck(const typename FlatCircuit::Layer& outputLayer, const ActivationTruthTable& att, 
+                     const std::vector<GateMode>& modes, SearchStats& stats, const CostModel* cost = nullptr) :
+        stats(stats), cost(cost), modes(modeMask(modes)), constructGates(outputGatesKernel<Wires>(this->modes))
+    {
+        rowOutputs.resize(att.rows);
+        rowCares.resize(att.rows);
+        projections.resize(att.rows);
+
+        for (uint8_t o = 0; o < outputLayer.size; o++)
+            for (uint64_t r = 0; r < att.rows; r++)
+            {
+                rowOutputs[r] |= (att.output(o)[r / 64]    >> (r % 64) & 1) << o;
+                rowCares[r]   |= (~att.dontCare(o)[r / 64] >> (r % 64) & 1) << o;
+            }
+
+        const uint16_t nVisible = outputLayer.gateOffset - outputLayer.inputOffset;
+        cache.length = nVisible * att.words;
+        cached = outputLayer.inputOffset > 0 and nVisible < 64 and
+            (1ul << nVisible) * att.words * outputLayer.size >= cacheMinCost;
+    }
+
+    bool separable(const typename FlatCircuit::Layer& outputLayer, const ActivationTruthTable& att)
+    {
+        const uint16_t nVisible = outputLayer.gateOffset - outputLayer.inputOffset;
+
+        for (uint64_t r = 0; r < att.rows; r++)
+            projections[r] = { 0, r };
+
+        for (uint16_t v = 0; v < nVisible; v++)
+        {
+            const uint64_t* column = att.wire(outputLayer.inputOffset + v);
+            for (uint64_t w = 0; w < att.words; w++)
+                for (uint64_t bits = column[w]; bits; bits &= bits - 1)
+                {
+                    uint64_t r = w * 64 + __builtin_ctzll(bits);
+                    if (r < att.rows) projections[r].first |= 1ul << v;
+                }
+        }
+
+        // rows with equal projections must agree on cared outputs,
+        // group rows by a table over all projections if small enough
+        if (nVisible <= directLimit)
+        {
+            classOnes.resize(1ul << nVisible);
+            classZeros.resize(1ul << nVisible);
+
+            bool conflict = false;
+            for (uint64_t r = 0; r < att.rows and !conflict; r++)
+            {
+                uint64_t p = projections[r].first;
+                classOnes[p]  |=  rowOutputs[r] & rowCares[r];
+                classZeros[p] |= ~rowOutputs[r] & rowCares[r];
+                conflict = classOnes[p] & classZeros[p];
+            }
+            
+            for (uint64_t r = 0; r < att.rows; r++)
+                classOnes[projections[r].first] = classZeros[projections[r].first] = 0;
+            return !conflict;
+        }
+
+        std::sort(projections.begin(), projections.end());
+
+        uint64_t ones = 0, zeros = 0;
+        for (uint64_t i = 0; i < projections.size(); i++)
+        {
+            if (i > 0 and projections[i].first != projections[i - 1].first)
+                ones = zeros = 0;
+
+            uint64_t r = projections[i].second;
+            ones  |=  rowOutputs[r] & rowCares[r];
+            zeros |= ~rowOutputs[r] & rowCares[r];
+            if (ones & zeros) return false;
+        }
+        return true;
+    }
+
+    bool tryConstruct(FlatCircuit& circuit, const ActivationTruthTable& att)
+    {
+        const typename FlatCircuit::Layer& outputLayer = circuit.layers.back();
+        Gate* outputGates = circuit.layerGates(circuit.layers.size() - 1);
+        stats.outputChecks++;
+        if (!cached)
+            return construct(circuit, att);
+
+        const uint64_t tail = att.rows % 64 ? (1ul << (att.rows % 64)) - 1 : ~0ul;
+        const uint64_t* columns = att.wire(outputLayer.inputOffset);
+        signature.assign(columns, columns + cache.length);
+        for (uint64_t w = att.words - 1; w < signature.size(); w += att.words)
+            signature[w] &= tail;
+
+        uint64_t h = SignatureSet::hash(signature.data(), signature.size());
+        uint64_t index = cache.find(signature.data(), h);
+        if (index != cache.count)
+        {
+            stats.cacheHits++;
+            auto gates = cachedGates.begin() + index * outputLayer.size;
+            for (uint8_t g = 0; g < outputLayer.size; g++)
+                if (!(outputGates[g] = *gates++).inputMask) return false;
+            return true;
+        }
+
+        bool constructed = construct(circuit, att);
+
+        if (cache.count == cacheLimit)
+        {
+            cache.clear();
+            cachedGates.clear();
+        }
+        cache.insert(signature.data(), h);
+
+        for (uint8_t g = 0; g < outputLayer.size; g++)
+            cachedGates.push_back(constructed ? outputGates[g] : Gate{ 0, outputGates[g].mode });
+        return constructed;
+    }
+
+    bool construct(FlatCircuit& circuit, const ActivationTruthTable& att)
+    {
+        const typename FlatCircuit::Layer& outputLayer = circuit.layers.back();
+        if (!separable(outputLayer, att))
+        {
+            stats.rejectedInseparable++;
+            return false;
+        }
+        return constructGates(circuit.layerGates(circuit.layers.size() - 1), outputLayer.size, 
+            outputLayer.inputOffset, outputLayer.gateOffset, att, modes, &stats, cost, &killers);
+    }
+};
+
+
+// true if a layer emits a constant column or a column, which
+// duplicates another wire that is visible to the following layers
+template<typename Layer>
+static bool isRedundantLayer(
+    const Layer& layer,
+    const ActivationTruthTable& att,
+    bool balanced
+) {
+    const uint64_t tail = att.rows % 64 ? (1ul << (att.rows % 64)) - 1 : ~0ul;
+
+    for (uint8_t g = 0; g < layer.size; g++)
+    {
+        const uint64_t* column = att.wire(layer.gateOffset + g);
+
+        uint64_t ones = 0, zeros = 0;
+        for (uint64_t w = 0; w < att.words; w++)
+        {
+            uint64_t valid = w == att.words - 1 ? tail : ~0ul;
+            ones  |=  column[w] & valid;
+            zeros |= ~column[w] & valid;
+        }
+        if (!ones or !zeros) return true;
+
+        // with balanced layers only the gates of this layer are 
+        // visible to the next, duplicates of inputs pass them on
+        for (uint16_t v = balanced ? layer.gateOffset : 0; v < layer.gateOffset + g; v++)
+        {
+            const uint64_t* other = att.wire(v);
+            uint64_t diff = 0;
+            for (uint64_t w = 0; w < att.words; w++)
+                diff |= (column[w] ^ other[w]) & (w == att.words - 1 ? tail : ~0ul);
+            if (!diff) return true;
+        }
+    }
+    return false;
+}
+
+
+// gate of a layer whose wire the following layer does not see like
+// the others, the builders filter the connection to the second
+// visible wire, -1 if the layer gates are interchangeable
+static int pinnedGate(uint16_t gateOffset, uint8_t size, uint16_t nextInputOffset)
+{
+    const int pinned = nextInputOffset + 1 - gateOffset;
+    return pinned >= 0 and pinned < size ? pinned : -1;
+}
+
+static bool filtersConnection(const LayerBuilder& builder)
+{
+    for (auto& combo : builder.modeCombos)
+        for (auto& group : combo.groups)
+            if (group.filtered) return true;
+    return false;
+}
+
+// masked activation columns of all layer gates, sorted columns give
+// layers computing the same functions in any gate order the same
+// signature, the column of a pinned gate keeps the first place
+static void layerSignature(
+    const ActivationTruthTable& att,
+    uint16_t gateOffset,
+    uint8_t size,
+    bool sorted,
+    int pinned,
+    std::vector<uint64_t>& signature,
+    std::vector<uint8_t>& order
+) {
+    const uint64_t tail = att.rows % 64 ? (1ul << (att.rows % 64)) - 1 : ~0ul;
+    const uint64_t* columns = att.wire(gateOffset);
+
+    if (!sorted or size < 2)
+    {
+        signature.assign(columns, columns + size * att.words);
+        for (uint64_t w = att.words - 1; w < signature.size(); w += att.words)
+            signature[w] &= tail;
+        return;
+    }
+
+    order.resize(size);
+    std::iota(order.begin(), order.end(), 0);
+    if (pinned >= 0)
+        std::swap(order[0], order[pinned]);
+
+    std::sort(order.begin() + (pinned >= 0), order.end(), [&](uint8_t a, uint8_t b)
+    {
+        for (uint64_t w = 0; w < att.words; w++)
+        {
+            const uint64_t valid = w == att.words - 1 ? tail : ~0ul;
+            const uint64_t x = columns[a * att.words + w] & valid;
+            const uint64_t y = columns[b * att.words + w] & valid;
+            if (x != y) return x < y;
+        }
+        return false;
+    });
+
+    signature.resize(size * att.words);
+    for (uint8_t g = 0; g < size; g++)
+    {
+        std::copy(columns + order[g] * att.words, columns + (order[g] + 1) * att.words, signature.begin() + g * att.words);
+        signature[g * att.words + att.words - 1] &= tail;
+    }
+}
+
+
+template<typename Wires>
+void logic::selectDistinctFirstLayers(
+    LayerBuilder& builder,
+    const BasicTruthTable<Wires>& truthTable,
+    bool balanced,
+    const SolveOptions& options
+) {
+    // a layer without combinations selects none
+    builder.selection = std::make_shared<const std::vector<uint64_t>>();
+    builder.selected = builder.combinations == 0;
+    if (builder.selected)
+        return;
+
+    // circuit with the first hidden layer feeding a single output
+    BasicFlatCircuit<Wires> circuit({ uint8_t(builder.gateOffset), builder.size, 1 }, balanced);
+    builder.unrank(0, circuit.layerGates(1));
+
+    ActivationTruthTable att = computeActivationTruthTable(circuit, truthTable);
+    
+    SignatureSet seen;
+    seen.length = builder.size * att.words;
+
+    // the following layer is not known, its filtered connection
+    // may reach into this layer
+    const int pinned = pinnedGate(builder.gateOffset, builder.size, balanced ? builder.gateOffset : 0);
+
+    std::vector<uint64_t> selection;
+    std::vector<uint64_t> signature;
+    std::vector<uint8_t> order;
+    for (uint64_t i = 0; i < builder.combinations; i++)
+    {
+        const auto& layer = circuit.layers[1];
+        builder.unrank(i, circuit.layerGates(1));
+        updateLayerActivations(circuit, 1, att);
+
+        if (options.pruneRedundant and isRedundantLayer(layer, att, balanced))
+            continue;
+
+        if (options.pruneEquivalent)
+        {
+            layerSignature(att, layer.gateOffset, layer.size, options.pruneSymmetric, pinned, signature, order);
+
+            uint64_t h = SignatureSet::hash(signature.data(), signature.size());
+            if (seen.contains(signature.data(), h)) continue;
+            seen.insert(signature.data(), h);
+        }
+
+        selection.push_back(i);
+    }
+
+    builder.selection = std::make_shared<const std::vector<uint64_t>>(std::move(selection));
+    builder.selected = true;
+}
+
+
+
+
+template<typename Wires>
+void logic::orderFirstLayers(
+    LayerBuilder& builder,
+    const BasicTruthTable<Wires>& truthTable,
+    bool balanced
+) {
+    if (builder.size > 16 or builder.count() == 0 or builder.count() > 1ul << 24)
+        return;
+
+    // circuit with the first hidden layer feeding the outputs
+    const uint16_t nOutputs = std::max<uint16_t>(1, truthTable.outputWidth());
+    BasicFlatCircuit<Wires> circuit({ uint8_t(builder.gateOffset), builder.size, uint8_t(nOutputs) }, balanced);
+    ActivationTruthTable att = computeActivationTruthTable(circuit, truthTable);
+
+    // rows and cared ones per output for each joint activation state
+    // of the layer, states are reset through the list of those seen
+    std::vector<uint32_t> states(att.rows);
+    std::vector<uint32_t> rows(1ul << builder.size), cared(nOutputs << builder.size), ones(nOutputs << builder.size);
+    std::vector<uint32_t> seen;
+
+    auto entropy = [](double n, double k)
+    {
+        if (k == 0 or k == n) return 0.0;
+        return -k * log2(k / n) - (n - k) * log2((n - k) / n);
+    };
+
+    struct Score
+    {
+        double uncertainty;     // entropy of the outputs left given the state
+        uint64_t distinct;      // distinct activation states
+        uint64_t inputs;        // gate inputs
+        uint64_t index;
+    };
+    std::vector<Score> scores(builder.count());
+
+    for (uint64_t i = 0; i < builder.count(); i++)
+    {
+        const auto& layer = circuit.layers[1];
+        builder.unrank(i, circuit.layerGates(1));
+        updateLayerActivations(circuit, 1, att);
+
+        std::fill(states.begin(), states.end(), 0);
+        uint64_t inputs = 0;
+        for (uint8_t g = 0; g < layer.size; g++)
+        {
+            const uint64_t* column = att.wire(layer.gateOffset + g);
+            for (uint64_t r = 0; r < att.rows; r++)
+                states[r] |= uint32_t(column[r / 64] >> (r % 64) & 1) << g;
+            inputs += wireCount(circuit.layerGates(1)[g].inputMask);
+        }
+
+        for (uint64_t r = 0; r < att.rows; r++)
+        {
+            const uint32_t state = states[r];
+            if (rows[state]++ == 0) seen.push_back(state);
+
+            for (uint16_t o = 0; o < nOutputs; o++)
+                if (!(att.dontCare(o)[r / 64] >> (r % 64) & 1))
+                {
+                    cared[state * nOutputs + o]++;
+                    ones[state * nOutputs + o] += att.output(o)[r / 64] >> (r % 64) & 1;
+                }
+        }
+
+        double uncertainty = 0;
+        for (uint32_t state : seen)
+        {
+            for (uint16_t o = 0; o < nOutputs; o++)
+            {
+                uncertainty += entropy(cared[state * nOutputs + o], ones[state * nOutputs + o]);
+                cared[state * nOutputs + o] = ones[state * nOutputs + o] = 0;
+            }
+            rows[state] = 0;
+        }
+
+        scores[i] = { uncertainty, seen.size(), inputs, builder.selected ? (*builder.selection)[i] : i };
+        seen.clear();
+    }
+
+    // most informative layers first, then the most distinct states
+    // and the fewest inputs, otherwise in enumeration order
+    std::stable_sort(scores.begin(), scores.end(), [](const Score& a, const Score& b)
+    {
+        if (a.uncertainty != b.uncertainty) return a.uncertainty < b.uncertainty;
+        if (a.distinct != b.distinct) return a.distinct > b.distinct;
+        return a.inputs < b.inputs;
+    });
+
+    std::vector<uint64_t> selection(scores.size());
+    for (uint64_t i = 0; i < scores.size(); i++)
+        selection[i] = scores[i].index;
+    builder.selection = std::make_shared<const std::vector<uint64_t>>(std::move(selection));
+    builder.selected = true;
+}
+
+
+
+
+// receiver of all solutions of a search in place of the first one
+template<typename Wires>
+struct logic::SearchSink
+{
+    // cost model of the output gates and the bound, the first 
+    // output gates found are taken without one
+    const CostModel* cost = nullptr;
+
+    // called serialized for each solution with its circuit combination
+    // and cost, the search ends when it returns false
+    std::function<bool(uint64_t, double, const BasicSequentialCircuit<Wires>&)> accept;
+
+    // combinations which can not cost less are skipped if set
+    const std::atomic<double>* bound = nullptr;
+};
+
+
+template<typename Wires>
+static ActivationTruthTable transposeTruthTable(
+    uint16_t nInputs,
+    uint16_t nWires,
+    uint16_t nOutputs,
+    const BasicTruthTable<Wires>& truthTable);
+
+
+template<typename Wires>
+struct logic::SearchBatch
+{
+    // tables of the rows of the search table in the same order, 
+    // whose outputs are checked instead of the search table
+    std::vector<BasicTruthTable<Wires>> tables;
+
+    // first solution of each table, written by the search
+    std::vector<std::optional<BasicSequentialCircuit<Wires>>> solutions;
+};
+
+
+static void checkLayerSizes(const std::vector<uint8_t>& layerSizes)
+{
+    if (layerSizes.size() < 2)
+        throw std::invalid_argument("Solver expects at least input and output layer sizes.");
+    if (std::find_if(layerSizes.begin(), layerSizes.end(), [](uint8_t s){ return s == 0; }) != layerSizes.end())
+        throw std::invalid_argument("Solver expects layer sizes to be greater 0");    
+}
+
+// layer builders of all hidden layers for modes in ascending order
+static std::vector<LayerBuilder> buildLayers(
+    const std::vector<uint8_t>& layerSizes,
+    const std::vector<GateMode>& modes,
+    bool balanced,
+    const SolveOptions& options
+) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<LayerBuilder> layerBuilders;
+    uint16_t g = 0;
+    for (uint8_t i = 1; i < layerSizes.size() - 1; i++)
+    {
+        uint16_t inputOffset = balanced ? g : 0;
+        g += layerSizes[i - 1];
+        layerBuilders.emplace_back(layerSizes[i], inputOffset, g, modes, balanced);
+
+        const LayerBuilder& builder = layerBuilders.back();
+        if (options.progress)
+            std::cout << "layer combinations: " << builder.combinations
+                      << " (" << round(1000.0 * builder.combinations / powl(modes.size() * builder.gateCons, builder.size)) / 10.0 << "%) " 
+                      << std::endl;
+    }
+
+    if (options.stats)
+        options.stats->buildSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return layerBuilders;
+}
+
+
+template<typename Wires>
+std::optional<BasicSequentialCircuit<Wires>> BasicSequentialCircuit<Wires>::solve(
+    std::vector<uint8_t> layerSizes,
+    TruthTable& truthTable,
+    std::vector<GateMode> modes,
+    bool balanced,
+    const SolveOptions& options
+) {
+    checkLayerSizes(layerSizes);
+    std::sort(modes.begin(), modes.end());
+    const TruthTable table = truthTable.compacted(layerSizes.back());
+
+    // the first hidden layer is ordered after its distinct layers are selected
+    auto enumerationLayers = [&]()
+    {
+        auto layerBuilders = buildLayers(layerSizes, modes, balanced, options);
+        if (options.orderCandidates and !layerBuilders.empty() and 
+            layerBuilders[0].count() > 0 and layerBuilders[0].combinations <= 1ul << 24)
+        {
+            auto start = std::chrono::steady_clock::now();
+            if (options.pruneEquivalent or options.pruneRedundant)
+                selectDistinctFirstLayers(layerBuilders[0], table, balanced, options);
+            orderFirstLayers(layerBuilders[0], table, balanced);
+
+            if (options.stats)
+                options.stats->buildSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        return layerBuilders;
+    };
+
+    // solutions are verified on the table before compacting
+    auto verified = [&](std::optional<BasicSequentialCircuit> circuit)
+    {
+        if (circuit and !circuit->satisfies(truthTable))
+            throw std::logic_error("Solution does not satisfy the truth table.");
+        return circuit;
+    };
+
+    auto solveEngine = [&]() -> std::optional<BasicSequentialCircuit>
+    {
+        if (options.engine == SolveOptions::Engine::SAT)
+            return solveSAT(layerSizes, table, modes, balanced, options);
+
+        if (options.engine == SolveOptions::Engine::BIDIRECTIONAL)
+            return searchBidirectional(layerSizes, buildLayers(layerSizes, modes, balanced, options), table, modes, balanced, options);
+
+        if (options.engine == SolveOptions::Engine::LOCAL)
+        {
+            auto result = solveLocal(layerSizes, table, modes, balanced, options);
+            if (result.mismatches == 0) return result.circuit;
+            return {};
+        }
+
+        return search(layerSizes, enumerationLayers(), table, modes, balanced, options);
+    };
+
+    // results of the whole combination range are cached
+    if constexpr (std::is_same_v<Wires, uint64_t>)
+        if (!options.cache.empty() and options.shards <= 1 and options.checkpoint.empty())
+        {
+            SolutionCache cache{ options.cache };
+            auto cached = cache.lookup(table, layerSizes, modes, balanced, options);
+            if (cached.cached)
+            {
+                if (options.stats) options.stats->cachedResults++;
+                if (options.progress) std::cout << "cached result" << std::endl;
+                return verified(cached.solution);
+            }
+
+            // the local search does not prove the absence of solutions
+            auto circuit = verified(solveEngine());
+            if (circuit or options.engine != SolveOptions::Engine::LOCAL)
+                cache.store(table, layerSizes, modes, balanced, options, circuit);
+            return circuit;
+        }
+
+    return verified(solveEngine());
+}
+
+
+template<typename Wires>
+void BasicSequentialCircuit<Wires>::solveAll(
+    std::vector<uint8_t> layerSizes,
+    const TruthTable& truthTable,
+    std::vector<GateMode> modes,
+    const SolutionCallback& onSolution,
+    bool balanced,
+    const SolveOptions& options
+) {
+    checkLayerSizes(layerSizes);
+    std::sort(modes.begin(), modes.end());
+
+    if (options.engine != SolveOptions::Engine::ENUMERATE)
+        throw std::invalid_argument("Solutions are streamed from the enumeration engine.");
+
+    SearchSink<Wires> sink;
+    sink.accept = [&](uint64_t, double, const BasicSequentialCircuit& circuit) { return onSolution(circuit); };
+
+    search(layerSizes, buildLayers(layerSizes, modes, balanced, options), truthTable.compacted(layerSizes.back()), modes, balanced, options, &sink);
+}
+
+
+template<typename Wires>
+std::vector<BasicSequentialCircuit<Wires>> BasicSequentialCircuit<Wires>::solveBest(
+    std::vector<uint8_t> layerSizes,
+    const TruthTable& truthTable,
+    std::vector<GateMode> modes,
+    uint64_t k,
+    const CostModel& cost,
+    bool balanced,
+    const SolveOptions& options
+) {
+    checkLayerSizes(layerSizes);
+    std::sort(modes.begin(), modes.end());
+
+    if (options.engine != SolveOptions::Engine::ENUMERATE)
+        throw std::invalid_argument("Solutions are streamed from the enumeration engine.");
+    if (cost.gate < 0 or cost.input < 0 or std::any_of(std::begin(cost.modes), std::end(cost.modes), [](double c){ return c < 0; }))
+        throw std::invalid_argument("Cost bounds expect non-negative weights.");
+    if (k == 0)
+        return {};
+
+    // k cheapest solutions by cost and combination, the cost of 
+    // the k-th bounds the search once k solutions are found
+    struct Ranked
+    {
+        double cost;
+        uint64_t combo;
+        BasicSequentialCircuit circuit;
+
+        bool operator<(const Ranked& other) const
+        { return cost < other.cost or (cost == other.cost and combo < other.combo); }
+    };
+    std::vector<Ranked> best;
+    std::atomic<double> bound = INFINITY;
+
+    SearchSink<Wires> sink;
+    sink.cost = &cost;
+    sink.bound = &bound;
+    sink.accept = [&](uint64_t combo, double c, const BasicSequentialCircuit& circuit)
+    {
+        Ranked ranked{ c, combo, circuit };
+        if (best.size() == k and !(ranked < best.back()))
+            return true;
+
+        best.insert(std::upper_bound(best.begin(), best.end(), ranked), std::move(ranked));
+        if (best.size() > k)
+            best.pop_back();
+        if (best.size() == k)
+            bound = best.back().cost;
+        return true;
+    };
+
+    search(layerSizes, buildLayers(layerSizes, modes, balanced, options), truthTable.compacted(layerSizes.back()), modes, balanced, options, &sink);
+
+    std::vector<BasicSequentialCircuit> circuits;
+    for (auto& ranked : best)
+        circuits.push_back(std::move(ranked.circuit));
+    return circuits;
+}
+
+
+
+template<typename Wires>
+std::vector<std::optional<BasicSequentialCircuit<Wires>>> BasicSequentialCircuit<Wires>::solveBatch(
+    std::vector<uint8_t> layerSizes,
+    const std::vector<TruthTable>& truthTables,
+    std::vector<GateMode> modes,
+    bool balanced,
+    const SolveOptions& options
+) {
+    checkLayerSizes(layerSizes);
+    std::sort(modes.begin(), modes.end());
+
+    if (options.engine != SolveOptions::Engine::ENUMERATE)
+        throw std::invalid_argument("Batches are solved by the enumeration engine.");
+    if (options.shards > 1 or !options.checkpoint.empty())
+        throw std::invalid_argument("Shards and checkpoints apply to the search of a single truth table.");
+
+    std::vector<std::optional<BasicSequentialCircuit>> solutions(truthTables.size());
+    std::vector<TruthTable> tables;
+    std::vector<uint64_t> searched;
+
+    // tables solved before are answered by the cache
+    const SolutionCache cache{ options.cache };
+    for (uint64_t t = 0; t < truthTables.size(); t++)
+    {
+        if constexpr (std::is_same_v<Wires, uint64_t>)
+            if (!options.cache.empty())
+            {
+                auto cached = cache.lookup(truthTables[t], layerSizes, modes, balanced, options);
+                if (cached.cached)
+                {
+                    if (options.stats) options.stats->cachedResults++;
+                    solutions[t] = cached.solution;
+                    continue;
+                }
+            }
+        tables.push_back(truthTables[t].compacted(layerSizes.back()));
+        searched.push_back(t);
+    }
+
+    // distinct input rows of all tables in input order
+    std::vector<Wires> inputs;
+    for (auto& table : tables)
+        for (auto& entry : table.entries)
+            inputs.push_back(entry.inputBits);
+    std::sort(inputs.begin(), inputs.end(), [](const Wires& a, const Wires& b) { return wiresLess(a, b); });
+    inputs.erase(std::unique(inputs.begin(), inputs.end()), inputs.end());
+
+    Wires outputMask = 0;
+    for (uint8_t o = 0; o < layerSizes.back(); o++)
+        outputMask |= wireBit<Wires>(o);
+
+    // tables over all rows, rows of other tables are dont care, tables 
+    // with rows of equal inputs differing in cared outputs are unsolvable
+    SearchBatch<Wires> batch;
+    std::vector<uint64_t> batched;
+    for (uint64_t i = 0; i < tables.size(); i++)
+    {
+        TruthTable rows;
+        for (auto& input : inputs)
+            rows.entries.push_back({ input, 0, outputMask });
+
+        bool conflict = false;
+        for (auto& entry : tables[i].entries)
+        {
+            auto& row = rows.entries[std::lower_bound(inputs.begin(), inputs.end(), entry.inputBits, 
+                [](const Wires& a, const Wires& b) { return wiresLess(a, b); }) - inputs.begin()];
+            conflict = conflict or bool((row.outputBits ^ entry.outputBits) & ~row.dontCareBits & ~entry.dontCareBits);
+            row.outputBits |= entry.outputBits & ~entry.dontCareBits;
+            row.dontCareBits &= entry.dontCareBits;
+        }
+
+        if (conflict)
+            continue;
+        batch.tables.push_back(std::move(rows));
+        batched.push_back(i);
+    }
+
+    if (!batch.tables.empty())
+    {
+        TruthTable rows;
+        for (auto& input : inputs)
+            rows.entries.push_back({ input, 0, 0 });
+
+        batch.solutions.resize(batch.tables.size());
+        search(layerSizes, buildLayers(layerSizes, modes, balanced, options), rows, modes, balanced, options, nullptr, &batch);
+
+        for (uint64_t i = 0; i < batched.size(); i++)
+            solutions[searched[batched[i]]] = std::move(batch.solutions[i]);
+    }
+
+    if constexpr (std::is_same_v<Wires, uint64_t>)
+        if (!options.cache.empty())
+            for (uint64_t t : searched)
+                cache.store(truthTables[t], layerSizes, modes, balanced, options, solutions[t]);
+
+    return solutions;
+}
+
+
+
+
+template<typename Wires>
+std::optional<BasicSequentialCircuit<Wires>> BasicSequentialCircuit<Wires>::search(
+    const std::vector<uint8_t>& layerSizes,
+    const std::vector<LayerBuilder>& layerBuilders,
+    const TruthTable& truthTable,
+    const std::vector<GateMode>& modes,
+    bool balanced,
+    const SolveOptions& options,
+    SearchSink<Wires>* sink,
+    SearchBatch<Wires>* batch
+) {
+    // search with the narrowest wire state holding all wires, wider
+    // wire states only pay for the bits of circuits that need them
+    const uint16_t nWires = std::reduce(layerSizes.begin(), layerSizes.end() - 1, 0);
+    const uint16_t width  = std::max<uint16_t>(nWires, layerSizes.back());
+    if (width > wireCapacity<Wires>)
+        throw std::overflow_error("Circuit wires exceed the " + std::to_string(wireCapacity<Wires>) + " bit wire state.");
+
+    if constexpr (wireCapacity<Wires> > 64)
+        if (width <= wireCapacity<Wires> / 2)
+        {
+            using Half = HalfWires<Wires>;
+
+            // solutions are converted back for the sink of this width
+            SearchSink<Half> halfSink;
+            if (sink)
+            {
+                halfSink.cost  = sink->cost;
+                halfSink.bound = sink->bound;
+                halfSink.accept = [&](uint64_t combo, double cost, const BasicSequentialCircuit<Half>& circuit)
+                { return sink->accept(combo, cost, circuit.template convert<Wires>()); };
+            }
+
+            // and the tables and solutions of the batch
+            SearchBatch<Half> halfBatch;
+            if (batch)
+            {
+                for (auto& table : batch->tables)
+                    halfBatch.tables.push_back(table.template convert<Half>());
+                halfBatch.solutions.resize(batch->tables.size());
+            }
+
+            auto circuit = BasicSequentialCircuit<Half>::search(layerSizes, layerBuilders, truthTable.template convert<Half>(), 
+                modes, balanced, options, sink ? &halfSink : nullptr, batch ? &halfBatch : nullptr);
+
+            for (uint64_t t = 0; t < halfBatch.solutions.size(); t++)
+                if (halfBatch.solutions[t])
+                    batch->solutions[t] = halfBatch.solutions[t]->template convert<Wires>();
+
+            if (!circuit) return {};
+            return circuit->template convert<Wires>();
+        }
+
+    // output gates are enumerated as masks of the visible wires
+    const typename BasicFlatCircuit<Wires>::Layer outputLayer = BasicFlatCircuit<Wires>(layerSizes, balanced).layers.back();
+    if (outputLayer.gateOffset - outputLayer.inputOffset >= 64)
+        throw std::overflow_error("Output layer connections exceed the 64 bit index range.");
+
+    uint64_t nCircuitCombos = 1;
+    for (auto& builder : layerBuilders)
+        if (__builtin_mul_overflow(nCircuitCombos, builder.count(), &nCircuitCombos))
+            throw std::overflow_error("Circuit combinations exceed the 64 bit index range.");
+    if (options.progress)
+        std::cout << "circuit combinations: " << nCircuitCombos << std::endl;
+
+    // a hidden layer without combinations, too few visible wires
+    // for distinct connections of its gates
+    if (nCircuitCombos == 0)
+        return {};
+
+
+    // combination range of the shard, resumed from a checkpoint
+    // of the same shard if one was written before
+
+    if (options.shards == 0 or options.shard >= options.shards)
+        throw std::invalid_argument("Solver expects a shard index below the number of shards.");
+
+    Checkpoint checkpoint;
+    checkpoint.tableHash   = truthTable.hash();
+    checkpoint.layerSizes  = layerSizes;
+    checkpoint.modes       = modes;
+    checkpoint.balanced    = balanced;
+    checkpoint.enumeration = options.enumerationFlags();
+    for (auto& builder : layerBuilders)
+        checkpoint.layerCounts.push_back(builder.count());
+    checkpoint.begin = (unsigned __int128)nCircuitCombos * options.shard / options.shards;
+    checkpoint.end   = (unsigned __int128)nCircuitCombos * (options.shard + 1) / options.shards;
+    checkpoint.next  = checkpoint.begin;
+
+    const bool checkpointing = !options.checkpoint.empty();
+    if (checkpointing and wireCapacity<Wires> > 64)
+        throw std::invalid_argument("Checkpoints hold circuits of up to 64 wires.");
+    if (checkpointing and (sink or batch))
+        throw std::invalid_argument("Checkpoints hold the first solution of a search.");
+    if (checkpointing)
+        if (auto resumed = Checkpoint::read(options.checkpoint))
+        {
+            if (!resumed->compatible(checkpoint) or resumed->begin != checkpoint.begin or resumed->end != checkpoint.end)
+                throw std::invalid_argument("Checkpoint " + options.checkpoint + " belongs to a different search.");
+            if (resumed->found and resumed->solution)
+                return resumed->solution->template convert<Wires>();
+            if (resumed->found)
+                return {};
+            checkpoint.next = resumed->next;
+        }
+
+    const uint64_t rangeBegin = checkpoint.next;
+    const uint64_t rangeEnd   = checkpoint.end;
+    if (options.progress and (options.shards > 1 or rangeBegin != checkpoint.begin))
+        std::cout << "searching circuit combos: " << rangeBegin << " - " << rangeEnd << std::endl;
+    if (options.progress)
+        std::cout << std::endl;
+
+    const auto start = std::chrono::steady_clock::now();
+
+
+    // search circuit combinations
+    // -> split the combination index range into chunks, which are
+    //    processed by worker threads stealing chunks from each other
+    // -> check constructability of output layer against truth table
+
+    const unsigned nThreads = options.threads ? options.threads : 
+        std::max(1u, std::thread::hardware_concurrency());
+    const uint64_t nChunks   = std::min<uint64_t>(rangeEnd - rangeBegin, nThreads * 64ul);
+    const uint64_t chunkSize = nChunks ? (rangeEnd - rangeBegin + nChunks - 1) / nChunks : 0;
+
+    std::vector<WorkQueue> queues(nThreads);
+    for (uint64_t c = 0; c < nChunks; c++)
+        queues[c % nThreads].chunks.push_back({ 
+            rangeBegin + c * chunkSize, std::min(rangeEnd, rangeBegin + (c + 1) * chunkSize) });
+
+    // lowest combination of each chunk that is not searched yet,
+    // the end of the range once the chunk is searched completely
+    std::vector<std::atomic<uint64_t>> positions(nChunks);
+    for (uint64_t c = 0; c < nChunks; c++)
+        positions[c] = rangeBegin + c * chunkSize;
+
+
+    // lowest circuit combination of a solution found so far, the 
+    // highest of the lowest solutions of the tables of a batch
+    std::atomic<uint64_t> found = rangeEnd;
+    std::vector<std::atomic<uint64_t>> batchFound(batch ? batch->tables.size() : 0);
+    for (auto& f : batchFound)
+        f = rangeEnd;
+    std::atomic<uint64_t> searched = rangeBegin - checkpoint.begin;
+    const uint64_t resumed = searched;
+    std::optional<BasicSequentialCircuit> solution;
+    SearchStats stats;
+    std::mutex mutex;
+
+    // progress is printed by the first thread passing the next report time
+    const int64_t reportInterval = options.progressInterval * 1e9;
+    std::atomic<int64_t> nextReport = 0;
+
+    auto report = [&](bool final)
+    {
+        const int64_t now = std::chrono::nanoseconds(std::chrono::steady_clock::now() - start).count();
+        int64_t next = nextReport.load(std::memory_order_relaxed);
+        if (!final and (now < next or !nextReport.compare_exchange_strong(next, now + reportInterval)))
+            return;
+
+        const uint64_t s = searched.load(std::memory_order_relaxed);
+        const uint64_t total = checkpoint.end - checkpoint.begin;
+        const double rate = (s - resumed) / std::max(1e-9, now * 1e-9);
+
+        std::lock_guard lock(mutex);
+        std::cout << "\rcircuit combo: " << s << " / " << total 
+                  << " (" << uint64_t(rate) << "/s, eta " << uint64_t((total - s) / std::max(1.0, rate)) << "s)   " 
+                  << std::flush;
+    };
+
+    // checkpoint is written by the first thread passing the next write time
+    const int64_t checkpointInterval = options.checkpointInterval * 1e9;
+    std::atomic<int64_t> nextCheckpoint = checkpointInterval;
+
+    auto writeCheckpoint = [&](bool final)
+    {
+        const int64_t now = std::chrono::nanoseconds(std::chrono::steady_clock::now() - start).count();
+        int64_t next = nextCheckpoint.load(std::memory_order_relaxed);
+        if (!final and (now < next or !nextCheckpoint.compare_exchange_strong(next, now + checkpointInterval)))
+            return;
+
+        std::lock_guard lock(mutex);
+        checkpoint.next = found;
+        for (auto& position : positions)
+            checkpoint.next = std::min<uint64_t>(checkpoint.next, position);
+
+        // a solution is only the lowest once all combinations below 
+        // it are searched, or the first found without determinism
+        if (found < rangeEnd and (checkpoint.next >= found or (final and !options.deterministic)))
+        {
+            checkpoint.found = found.load();
+            checkpoint.solution = solution->template convert<uint64_t>();
+        }
+        checkpoint.write(options.checkpoint);
+    };
+
+    auto cancelled = [&](uint64_t circuitCombo)
+    {
+        uint64_t f = found.load(std::memory_order_relaxed);
+        return options.deterministic ? circuitCombo >= f : f != rangeEnd;
+    };
+
+    // lower bound of the cost of the gates following each hidden
+    // layer, gates have at least one input and the cheapest mode
+    const CostModel* cost = sink ? sink->cost : nullptr;
+    std::vector<double> costBounds(layerBuilders.size(), 0);
+    if (cost)
+    {
+        double gateCost = INFINITY;
+        for (auto m : modes) gateCost = std::min(gateCost, cost->gateCost(m, 1));
+
+        double bound = outputLayer.size * gateCost;
+        for (uint8_t l = layerBuilders.size(); l > 0; l--)
+        {
+            costBounds[l - 1] = bound;
+            bound += layerBuilders[l - 1].size * gateCost;
+        }
+    }
+
+    // true if combinations of this cost can not enter the solutions,
+    // equal costs only lose to lower combinations, which are already
+    // searched unless other threads may still find them
+    auto exceedsBound = [&](double c)
+    {
+        const double bound = sink->bound->load(std::memory_order_relaxed);
+        return options.deterministic and nThreads > 1 ? c > bound : c >= bound;
+    };
+
+    // number of circuit combinations below one combination of a layer
+    std::vector<uint64_t> strides(layerBuilders.size(), 1);
+    for (uint8_t l = layerBuilders.size(); l > 1; l--)
+        strides[l - 2] = strides[l - 1] * layerBuilders[l - 1].count();
+
+    // gates of each hidden layer pinned by a filtered connection of 
+    // the following hidden layer, output gates see all connections
+    std::vector<int> pinned(layerBuilders.size(), -1);
+    {
+        BasicFlatCircuit<Wires> shape(layerSizes, balanced);
+        for (uint8_t l = 1; l < layerBuilders.size(); l++)
+            if (filtersConnection(layerBuilders[l]))
+                pinned[l - 1] = pinnedGate(shape.layers[l].gateOffset, shape.layers[l].size, shape.layers[l + 1].inputOffset);
+    }
+
+    auto worker = [&](unsigned thread)
+    {
+        SearchChunk chunk;
+
+        // circuit of the current combination, hidden layers are
+        // only unranked when their combination index changes
+        BasicFlatCircuit<Wires> circuit(layerSizes, balanced);
+        for (uint8_t l = 1; l <= layerBuilders.size(); l++)
+            layerBuilders[l - 1].unrank(0, circuit.layerGates(l));
+
+        ActivationTruthTable att = computeActivationTruthTable(circuit, truthTable);
+
+        // combination index of each hidden layer, the digits of the
+        // mixed-radix circuit combination index
+        std::vector<uint64_t> layerIndices(layerBuilders.size());
+
+        // activation signatures of the layer combinations searched 
+        // under the current combinations of the preceding layers
+        std::vector<SignatureSet> seen(layerBuilders.size());
+        std::vector<std::vector<double>> seenCosts(layerBuilders.size());
+        std::vector<uint64_t> signature;
+        std::vector<uint8_t> order;
+        for (uint8_t l = 0; l < layerBuilders.size(); l++)
+            seen[l].length = layerBuilders[l].size * att.words;
+
+        // counters of this thread, merged when it is done
+        SearchStats threadStats;
+        OutputLayerCheck<Wires> outputCheck(circuit.layers.back(), att, modes, threadStats, cost);
+
+        // output and dont care columns of the tables of a batch, which
+        // are swapped into the activation truth table for their checks
+        std::vector<ActivationTruthTable> batchTargets;
+        std::vector<OutputLayerCheck<Wires>> batchChecks;
+        auto swapTargets = [&](uint64_t t)
+        {
+            std::swap(att.outputs, batchTargets[t].outputs);
+            std::swap(att.dontCares, batchTargets[t].dontCares);
+        };
+        if (batch)
+        {
+            batchChecks.reserve(batch->tables.size());
+            for (uint64_t t = 0; t < batch->tables.size(); t++)
+            {
+                batchTargets.push_back(transposeTruthTable(0, 0, outputLayer.size, batch->tables[t]));
+                swapTargets(t);
+                batchChecks.emplace_back(circuit.layers.back(), att, modes, threadStats, cost);
+                swapTargets(t);
+            }
+        }
+
+        // cost of the gates up to each hidden layer with a cost model
+        std::vector<double> layerCosts(layerBuilders.size() + 1, 0);
+        
+        while (popChunk(queues, thread, chunk))
+        {
+            const uint64_t id = (chunk.begin - rangeBegin) / chunkSize;
+            uint64_t circuitCombo = chunk.begin;
+            uint64_t reported = chunk.begin;
+            for (; circuitCombo < chunk.end and !cancelled(circuitCombo); circuitCombo++)
+            {
+                threadStats.combinations++;
+                if ((options.progress or checkpointing) and (threadStats.combinations & 0xfff) == 0)
+                {
+                    searched += circuitCombo - reported;
+                    reported = circuitCombo;
+                    positions[id].store(circuitCombo, std::memory_order_relaxed);
+                    if (options.progress) report(false);
+                    if (checkpointing) writeCheckpoint(false);
+                }
+
+                // lowest hidden layer whose combination changed
+                uint8_t changed = layerBuilders.size() + 1;
+
+                if (circuitCombo == chunk.begin)
+                {
+                    uint64_t layerIdx = circuitCombo;
+                    for (uint8_t l = layerBuilders.size(); l > 0; l--)
+                    {
+                        layerIndices[l - 1] = layerIdx % layerBuilders[l - 1].count();
+                        layerIdx /= layerBuilders[l - 1].count();
+                    }
+                    changed = 1;
+                }
+                else
+                {
+                    // increment the last digit and carry over
+                    for (uint8_t l = layerBuilders.size(); l > 0; l--)
+                    {
+                        changed = l;
+                        if (++layerIndices[l - 1] < layerBuilders[l - 1].count()) break;
+                        layerIndices[l - 1] = 0;
+                    }
+                }
+
+                // signatures of layers whose preceding layers changed
+                // are no longer comparable
+                for (uint8_t l = changed + (circuitCombo != chunk.begin); l <= layerBuilders.size(); l++)
+                {
+                    seen[l - 1].clear();
+                    seenCosts[l - 1].clear();
+                }
+
+
+                // activation columns of the layers below the changed 
+                // layer are kept, only the following layers are updated
+                bool pruned = false;
+                for (uint8_t l = changed; l <= layerBuilders.size() and !pruned; l++)
+                {
+                    const auto& layer = circuit.layers[l];
+                    layerBuilders[l - 1].unrank(layerIndices[l - 1], circuit.layerGates(l));
+                    updateLayerActivations(circuit, l, att);
+                    threadStats.layersUnranked++;
+
+                    if (cost)
+                    {
+                        const Gate* gates = circuit.layerGates(l);
+                        layerCosts[l] = layerCosts[l - 1];
+                        for (uint8_t g = 0; g < layer.size; g++)
+                            layerCosts[l] += cost->gateCost(gates[g].mode, wireCount(gates[g].inputMask));
+                    }
+
+                    if (options.pruneRedundant and isRedundantLayer(layer, att, balanced))
+                    {
+                        threadStats.prunedRedundant++;
+                        pruned = true;
+                    }
+                    else if (cost and sink->bound and exceedsBound(layerCosts[l] + costBounds[l - 1]))
+                    {
+                        threadStats.prunedBound++;
+                        pruned = true;
+                    }
+                    else if (options.pruneEquivalent)
+                    {
+                        layerSignature(att, layer.gateOffset, layer.size, options.pruneSymmetric, pinned[l - 1], signature, order);
+
+                        // equivalent layers are searched again if cheaper
+                        uint64_t h = SignatureSet::hash(signature.data(), signature.size());
+                        uint64_t index = seen[l - 1].find(signature.data(), h);
+                        if (index != seen[l - 1].count and (!cost or layerCosts[l] >= seenCosts[l - 1][index]))
+                        {
+                            threadStats.prunedEquivalent++;
+                            pruned = true;
+                        }
+                        // only layers entered at their first following 
+                        // combination are searched completely in this chunk
+                        else if (circuitCombo % strides[l - 1] == 0)
+                        {
+                            if (index == seen[l - 1].count)
+                            {
+                                seen[l - 1].insert(signature.data(), h);
+                                seenCosts[l - 1].push_back(layerCosts[l]);
+                            }
+                            else
+                                seenCosts[l - 1][index] = layerCosts[l];
+                        }
+                    }
+
+                    if (pruned)
+                    {
+                        // skip all combinations of the following layers
+                        threadStats.skipped += strides[l - 1] - 1 - circuitCombo % strides[l - 1];
+                        circuitCombo += strides[l - 1] - 1 - circuitCombo % strides[l - 1];
+                        for (uint8_t k = l + 1; k <= layerBuilders.size(); k++)
+                            layerIndices[k - 1] = layerBuilders[k - 1].count() - 1;
+                    }
+                }
+                if (pruned) continue;
+
+                if (batch)
+                {
+                    for (uint64_t t = 0; t < batch->tables.size(); t++)
+                    {
+                        if (options.deterministic ? circuitCombo >= batchFound[t] : batchFound[t] != rangeEnd)
+                            continue;
+
+                        swapTargets(t);
+                        const bool constructed = batchChecks[t].tryConstruct(circuit, att);
+                        swapTargets(t);
+                        if (!constructed) continue;
+
+                        std::lock_guard lock(mutex);
+                        if (stats.firstSolutionSeconds == 0)
+                            stats.firstSolutionSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                        if (circuitCombo < batchFound[t])
+                        {
+                            batchFound[t] = circuitCombo;
+                            batch->solutions[t] = circuit.materialize();
+
+                            uint64_t highest = 0;
+                            for (auto& f : batchFound)
+                                highest = std::max<uint64_t>(highest, f);
+                            found = highest;
+                        }
+                    }
+                    continue;
+                }
+
+                if (!outputCheck.tryConstruct(circuit, att))
+                    continue;
+
+                if (sink)
+                {
+                    double c = layerCosts.back();
+                    if (cost)
+                    {
+                        const Gate* gates = circuit.layerGates(circuit.layers.size() - 1);
+                        for (uint8_t g = 0; g < circuit.layers.back().size; g++)
+                            c += cost->gateCost(gates[g].mode, wireCount(gates[g].inputMask));
+                    }
+                    if (cost and sink->bound and exceedsBound(c))
+                        continue;
+
+                    // the search ends for all threads once the sink declines
+                    std::lock_guard lock(mutex);
+                    if (!cancelled(circuitCombo) and !sink->accept(circuitCombo, c, circuit.materialize()))
+                        found = rangeBegin;
+                    continue;
+                }
 
-std::optional<SequentialCircuit> SequentialCircuit::solve(
-    std::vector<uint8_t> layerSizes,
-    TruthTable& truthTable,
-    std::vector<Gate::Mode> modes,
-    bool balanced
-) {
-    if (layerSizes.size() < 2)
-        throw std::invalid_argument("Solver expects at least input and output layer sizes.");
-    if (std::find_if(layerSizes.begin(), layerSizes.end(), [](uint8_t s){ return s == 0; }) != layerSizes.end())
-        throw std::invalid_argument("Solver expects layer sizes to be greater 0");    
+                std::lock_guard lock(mutex);
+                if (found == rangeEnd)
+                    stats.firstSolutionSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                if (circuitCombo < found)
+                {
+                    found = circuitCombo;
+                    solution = circuit.materialize();
+                }
+                break;
+            }
 
-    
-    std::sort(modes.begin(), modes.end());
+            searched += std::min(circuitCombo, chunk.end) - reported;
+            positions[id].store(circuitCombo < chunk.end ? circuitCombo : rangeEnd, std::memory_order_relaxed);
+            if (options.progress)
+                report(false);
+        }
 
-    // prepare layer builders
-    
-    std::vector<LayerBuilder> layerBuilders(layerSizes.size() - 2);
-    for (uint8_t i = 1, g = 0; i < layerSizes.size() - 1; i++)
+        std::lock_guard lock(mutex);
+        stats += threadStats;
+    };
+
+    if (nThreads == 1)
+        worker(0);
+    else
     {
-        LayerBuilder& builder = layerBuilders[i - 1];
-        builder.size = layerSizes[i];
-        builder.inputOffset = balanced ? g : 0;
-        g += layerSizes[i - 1];
-        builder.gateOffset = g;
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < nThreads; t++)
+            threads.emplace_back(worker, t);
+        for (auto& thread : threads)
+            thread.join();
     }
 
-    // prepare layer combinations
-    
-    for (auto& builder : layerBuilders)
+    if (options.progress)
     {
-        // create layer gate mode combinations
+        report(true);
+        std::cout << std::endl;
+    }
 
-        auto modeCombos = uniqueCombinationsOI(builder.size, modes.size());
+    if (checkpointing)
+        writeCheckpoint(true);
 
+    stats.searchSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (options.stats)
+        *options.stats += stats;
 
-        // create layer gate connection combinations
+    return solution;
+}
 
-        uint64_t gateCons = (1ul << (builder.gateOffset - builder.inputOffset)) - 1;
-        uint64_t totalCons = powl(gateCons, builder.size);
-        builder.combinations.reserve(totalCons * modeCombos.size());
 
-        for (auto modeCombo : modeCombos)
-        {
-            std::vector<std::vector<uint64_t>> masks = {{}};
 
-            // optimize connections for gates of the same mode
-            uint8_t positions = 1;
-            for (int i = 0; i < modeCombo.size(); i++)
-            {
-                if (i == modeCombo.size() - 1 or modeCombo[i] != modeCombo[i+1])
-                {
-                    auto gateMasks = uniqueCombinationsOI(positions, gateCons, false);
-                    masks = cartesianProduct(masks, gateMasks);
-                    positions = 0;
-                }
-                positions++;
-            }
 
+template<typename Wires>
+std::optional<BasicSequentialCircuit<Wires>> BasicSequentialCircuit<Wires>::searchBidirectional(
+    const std::vector<uint8_t>& layerSizes,
+    const std::vector<LayerBuilder>& layerBuilders,
+    const TruthTable& truthTable,
+    const std::vector<GateMode>& modes,
+    bool balanced,
+    const SolveOptions& options
+) {
+    const uint8_t nHidden = layerBuilders.size();
+    if (nHidden < 2)
+        return search(layerSizes, layerBuilders, truthTable, modes, balanced, options);
 
-            // remove redundant single-input connections
-            if (balanced and modes.size() > 1 and (uint8_t)modes[1] < 4)
-                masks.erase(std::remove_if(masks.begin(), masks.end(),
-                [&](std::vector<uint64_t> maskCombo)
-                {
-                    for (int i = 0; i < modeCombo.size(); i++)
-                        if (modeCombo[i] < 4 and
-                            modeCombo[i] != (uint64_t)modes.front() and
-                            maskCombo[i] & (maskCombo[i] - 1) == 0)
-                            return true;
-                    return false;
-                }), masks.end());
-            else
-                masks.erase(std::remove_if(masks.begin(), masks.end(), 
-                [&](std::vector<uint64_t> maskCombo)
-                {
-                    for (int i = 0; i < modeCombo.size(); i++)
-                        if ((modeCombo[i] < 4 or 
-                             modeCombo[i] > 4 and
-                             modeCombo[i] != (uint64_t)modes.back()) and
-                            maskCombo[i] & (maskCombo[i] - 1) == 0)
-                            return true;
-                    return false;
-                }), masks.end());
-
-
-            // write to builder
-            for (auto maskCombo : masks)
-            {
-                Layer layer;
-                layer.inputOffset = builder.inputOffset;
-                layer.gateOffset = builder.gateOffset;
-                layer.gates.resize(builder.size);
+    if (options.shards > 1 or !options.checkpoint.empty())
+        throw std::invalid_argument("Shards and checkpoints apply to the enumeration engine.");
 
-                for (int i = 0; i < builder.size; i++)
-                {
-                    layer.gates[i].inputMask = (maskCombo[i] + 1) << builder.inputOffset;
-                    layer.gates[i].mode = modes[modeCombo[i]];
-                }
+    const uint16_t nWires = std::reduce(layerSizes.begin(), layerSizes.end() - 1, 0);
+    if (std::max<uint16_t>(nWires, layerSizes.back()) > wireCapacity<Wires>)
+        throw std::overflow_error("Circuit wires exceed the " + std::to_string(wireCapacity<Wires>) + " bit wire state.");
 
-                builder.combinations.push_back(layer);
-            }
+    for (auto& builder : layerBuilders)
+        if (builder.count() == 0) return {};
+
+    // middle layer splitting the layer combinations in halves, the
+    // layers up to it are enumerated forward and the following ones
+    // are searched for each distinct state of the middle layer
+    uint8_t middle = 1;
+    double split = INFINITY;
+    for (uint8_t m = 1; m < nHidden; m++)
+    {
+        double balance = 0;
+        for (uint8_t l = 0; l < nHidden; l++)
+            balance += (l < m ? 1 : -1) * std::log2(double(layerBuilders[l].count()));
+        if (std::abs(balance) <= split)
+        {
+            split = std::abs(balance);
+            middle = m;
         }
+    }
 
-        builder.combinations.shrink_to_fit();
+    BasicFlatCircuit<Wires> circuit(layerSizes, balanced);
+    for (uint8_t l = 1; l <= nHidden; l++)
+        layerBuilders[l - 1].unrank(0, circuit.layerGates(l));
 
+    ActivationTruthTable att = computeActivationTruthTable(circuit, truthTable);
 
+    SearchStats stats;
+    OutputLayerCheck<Wires> outputCheck(circuit.layers.back(), att, modes, stats);
 
+    // wires the following layers see of the state after a hidden layer,
+    // the layer itself with balanced layers or all hidden wires so far
+    auto stateBegin = [&](uint8_t l) { return balanced ? circuit.layers[l].gateOffset : circuit.layers[1].gateOffset; };
+    auto stateEnd   = [&](uint8_t l) { return circuit.layers[l].gateOffset + circuit.layers[l].size; };
 
-        std::cout << "layer combinations: " << builder.combinations.size()
-                  << " (" << round(1000.0 * builder.combinations.size() / powl(modes.size() * gateCons, builder.size)) / 10.0 << "%) " 
-                  << std::endl;
+    // distinct states reached after each hidden layer up to the middle,
+    // a state seen before is searched completely already
+    static constexpr uint64_t stateLimit = 1ul << 22;
+    std::vector<SignatureSet> states(middle);
+    std::vector<int> pinned(middle, -1);
+    for (uint8_t l = 1; l <= middle; l++)
+    {
+        states[l - 1].length = (stateEnd(l) - stateBegin(l)) * att.words;
+        if (filtersConnection(layerBuilders[l]))
+            pinned[l - 1] = pinnedGate(stateBegin(l), stateEnd(l) - stateBegin(l), circuit.layers[l + 1].inputOffset);
     }
+    std::vector<uint64_t> signature;
+    std::vector<uint8_t> order;
 
 
-    uint64_t nCircuitCombos = 1;
-    for (auto& builder : layerBuilders)
-        nCircuitCombos *= builder.combinations.size();
-    std::cout << "circuit combinations: " << nCircuitCombos << std::endl << std::endl;
+    // remaining layers as a circuit with the wires visible after the 
+    // middle layer as inputs, their masks are shifted by the first one
+    const uint16_t shift = balanced ? circuit.layers[middle].gateOffset : 0;
+    std::vector<uint8_t> subSizes(layerSizes.begin() + middle, layerSizes.end());
+    subSizes.front() = stateEnd(middle) - shift;
 
+    std::vector<LayerBuilder> subBuilders;
+    uint16_t g = 0;
+    for (uint8_t i = 1; i < subSizes.size() - 1; i++)
+    {
+        uint16_t inputOffset = balanced ? g : 0;
+        g += subSizes[i - 1];
+        subBuilders.emplace_back(subSizes[i], inputOffset, g, modes, balanced);
+    }
 
-    // create circuit combinations
+    SearchStats subStats;
+    SolveOptions subOptions = options;
+    subOptions.progress = false;
+    subOptions.stats = &subStats;
 
-    // optimize circuit combinations
+    // rows of equal visible wires are merged into one row of the outputs
+    // cared for in any of them, the state separates differing outputs
+    TruthTable subTable;
+    std::unordered_map<Wires, uint64_t, WiresHash> subRows;
 
-    Layer inputLayer;
-    inputLayer.gateOffset = 0;
-    inputLayer.inputOffset = 0;
-    inputLayer.gates.resize(layerSizes.front(), { 0, Gate::Mode::IN });
-    
-    Layer outputLayer;
-    outputLayer.gateOffset = std::reduce(layerSizes.begin(), layerSizes.end()) - layerSizes.back();
-    outputLayer.inputOffset = balanced ? outputLayer.gateOffset - layerSizes[layerSizes.size() - 2] : 0;
-    outputLayer.gates.resize(layerSizes.back());
-    
-    
+    auto join = [&]() -> std::optional<BasicSequentialCircuit>
+    {
+        stats.middleStates++;
+        subTable.entries.clear();
+        subRows.clear();
+        for (uint64_t r = 0; r < att.rows; r++)
+        {
+            // more than 64 wires may be visible with wide wire states
+            Wires projection = 0;
+            for (uint16_t w = shift; w < stateEnd(middle); w++)
+                if (att.wire(w)[r / 64] >> (r % 64) & 1)
+                    projection |= wireBit<Wires>(w - shift);
+
+            const auto& entry = truthTable.entries[r];
+            auto [row, inserted] = subRows.emplace(projection, subTable.entries.size());
+            if (inserted)
+                subTable.entries.push_back({ projection, entry.outputBits & ~entry.dontCareBits, entry.dontCareBits });
+            else
+            {
+                auto& merged = subTable.entries[row->second];
+                merged.outputBits |= entry.outputBits & ~entry.dontCareBits;
+                merged.dontCareBits &= entry.dontCareBits;
+            }
+        }
 
-    ActivationTruthTable att;
+        // the first remaining layer has no preceding layers within the
+        // search, its distinct combinations are selected for each state
+        if (subBuilders[0].combinations <= 1ul << 24 and (options.pruneEquivalent or options.pruneRedundant))
+            selectDistinctFirstLayers(subBuilders[0], subTable, balanced, options);
+
+        return search(subSizes, subBuilders, subTable, modes, balanced, subOptions);
+    };
 
-    // search circuit combinations
-    // -> check constructability of output layer against truth table
 
-    for (uint64_t circuitCombo = 0; circuitCombo < nCircuitCombos; circuitCombo++)
+    // enumerate the layers up to the middle layer in combination order,
+    // the first solution joined has the lowest circuit combination
+    std::optional<BasicSequentialCircuit> solution;
+
+    std::function<bool(uint8_t)> forward = [&](uint8_t l) -> bool
     {
-        SequentialCircuit circuit;
-        circuit.layers.push_back(inputLayer);
-        
-        uint64_t layerIdx = circuitCombo;
-        for (auto b = layerBuilders.rbegin(); b != layerBuilders.rend(); b++)
+        const auto& layer = circuit.layers[l];
+        for (uint64_t i = 0; i < layerBuilders[l - 1].count(); i++)
         {
-            circuit.layers.insert(
-                circuit.layers.begin() + 1, 
-                b->combinations[layerIdx % b->combinations.size()]);
+            layerBuilders[l - 1].unrank(i, circuit.layerGates(l));
+            updateLayerActivations(circuit, l, att);
+            stats.layersUnranked++;
 
-            layerIdx /= b->combinations.size();
-        }
-        
-        circuit.layers.push_back(outputLayer);
+            if (options.pruneRedundant and isRedundantLayer(layer, att, balanced))
+            {
+                stats.prunedRedundant++;
+                continue;
+            }
 
-        std::cout << "\rcircuit combo: " << circuitCombo << " / " << nCircuitCombos;
-        
+            // with balanced layers only this layer is visible to the next,
+            // rows it does not tell apart can not get different outputs
+            if (balanced and !outputCheck.separable({ layer.gateOffset, uint16_t(layer.gateOffset + layer.size), layer.size }, att))
+            {
+                stats.rejectedInseparable++;
+                continue;
+            }
 
-        if (circuitCombo == 0)
-            att = computeActivationTruthTable(circuit, truthTable);
-        else
-            updateActivationTruthTable(circuit, att, 
-                circuitCombo % layerBuilders.back().combinations.size() == 0 ?
-                1 : layerBuilders.size());
+            layerSignature(att, stateBegin(l), stateEnd(l) - stateBegin(l), options.pruneSymmetric, pinned[l - 1], signature, order);
+            uint64_t h = SignatureSet::hash(signature.data(), signature.size());
+            if (states[l - 1].contains(signature.data(), h))
+            {
+                stats.prunedEquivalent++;
+                continue;
+            }
+            if (states[l - 1].count < stateLimit)
+                states[l - 1].insert(signature.data(), h);
 
-        if (tryConstructOutputLayer(circuit, att, modes))
-        {
-            std::cout << std::endl;
-            return circuit;
+            if (l < middle)
+            {
+                if (forward(l + 1)) return true;
+                continue;
+            }
+
+            auto remaining = join();
+            if (!remaining) continue;
+
+            // shift the gates of the remaining layers into the circuit
+            for (uint8_t k = 1; k < remaining->layers.size(); k++)
+                for (uint8_t gate = 0; gate < remaining->layers[k].gates.size(); gate++)
+                {
+                    const auto& found = remaining->layers[k].gates[gate];
+                    circuit.layerGates(middle + k)[gate] = { found.inputMask << shift, found.mode };
+                }
+            solution = circuit.materialize();
+            return true;
         }
-    }
-    
-    std::cout << std::endl;
-    return {};
+        return false;
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+    forward(1);
+
+    if (options.progress)
+        std::cout << "middle states: " << stats.middleStates << " after layer " << int(middle) << std::endl;
+
+    // counters of the remaining layers, timed as part of the search
+    subStats.searchSeconds = 0;
+    stats += subStats;
+    stats.searchSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (options.stats)
+        *options.stats += stats;
+
+    return solution;
 }
 
 
 
 
-uint64_t logic::SequentialCircuit::Gate::getActivation(uint64_t activation) const
+template<typename Wires>
+uint64_t logic::BasicGate<Wires>::getActivation(Wires activation) const
 {
-    uint64_t maskedActivation = activation & inputMask;
+    Wires maskedActivation = activation & inputMask;
 
     switch (uint8_t(mode) & 3)
     {
         case uint8_t(Mode::AND):   return uint64_t(maskedActivation == inputMask) ^ (uint64_t(mode) >> 2);
-        case uint8_t(Mode::OR):    return uint64_t(maskedActivation != 0)         ^ (uint64_t(mode) >> 2); 
-        case uint8_t(Mode::XOR):   return __builtin_parityll(maskedActivation)    ^ (uint64_t(mode) >> 2);
+        case uint8_t(Mode::OR):    return uint64_t(bool(maskedActivation))        ^ (uint64_t(mode) >> 2); 
+        case uint8_t(Mode::XOR):   return wireParity(maskedActivation)            ^ (uint64_t(mode) >> 2);
     }
     return 0;
 }
 
+template<typename Wires>
+uint64_t logic::BasicGate<Wires>::getActivation(
+    const ActivationTruthTable& activationTruthTable, 
+    uint64_t word
+) const {
+    const uint64_t* activations = activationTruthTable.activations.data() + word;
+    const uint64_t  words       = activationTruthTable.words;
 
+    Wires mask = inputMask;
+    uint64_t activation = activations[lowestWire(mask) * words];
+    clearLowestWire(mask);
 
+    switch (uint8_t(mode) & 3)
+    {
+        case uint8_t(Mode::AND): for (; mask; clearLowestWire(mask)) activation &= activations[lowestWire(mask) * words]; break;
+        case uint8_t(Mode::OR):  for (; mask; clearLowestWire(mask)) activation |= activations[lowestWire(mask) * words]; break;
+        case uint8_t(Mode::XOR): for (; mask; clearLowestWire(mask)) activation ^= activations[lowestWire(mask) * words]; break;
+    }
 
-ActivationTruthTable logic::computeActivationTruthTable(
-    const SequentialCircuit& circuit,
-    const TruthTable& truthTable
+    // invert all rows for negated modes
+    return activation ^ -(uint64_t(mode) >> 2);
+}
+
+
+
+
+template<typename Wires>
+Wires logic::BasicSequentialCircuit<Wires>::evaluate(const Wires& inputBits) const
+{
+    Wires activation = inputBits & lowWires<Wires>(layers.front().gates.size());
+    for (uint8_t l = 1; l < layers.size() - 1; l++)
+        for (uint8_t g = 0; g < layers[l].gates.size(); g++)
+            activation |= Wires(layers[l].gates[g].getActivation(activation)) << (layers[l].gateOffset + g);
+
+    Wires outputBits = 0;
+    for (uint8_t g = 0; g < layers.back().gates.size(); g++)
+        outputBits |= Wires(layers.back().gates[g].getActivation(activation)) << g;
+    return outputBits;
+}
+
+template<typename Wires>
+bool logic::BasicSequentialCircuit<Wires>::satisfies(const TruthTable& truthTable) const
+{
+    const Wires outputMask = lowWires<Wires>(layers.back().gates.size());
+    for (auto& entry : truthTable.entries)
+        if ((evaluate(entry.inputBits) ^ entry.outputBits) & ~entry.dontCareBits & outputMask)
+            return false;
+    return true;
+}
+
+template<typename Wires>
+double logic::BasicSequentialCircuit<Wires>::cost(const CostModel& model) const
+{
+    double c = 0;
+    for (uint8_t l = 1; l < layers.size(); l++)
+        for (auto& gate : layers[l].gates)
+            c += model.gateCost(gate.mode, wireCount(gate.inputMask));
+    return c;
+}
+
+
+
+
+template<typename Wires>
+BasicFlatCircuit<Wires>::BasicFlatCircuit(const std::vector<uint8_t>& layerSizes, bool balanced)
+{
+    uint16_t g = 0;
+    for (uint8_t l = 0; l < layerSizes.size(); l++)
+    {
+        layers.push_back({ uint16_t(balanced and l > 1 ? g - layerSizes[l - 1] : 0), g, layerSizes[l] });
+        g += layerSizes[l];
+    }
+    gates.resize(layers.back().gateOffset + layers.back().size, { 0, GateMode::IN });
+}
+
+template<typename Wires>
+BasicSequentialCircuit<Wires> BasicFlatCircuit<Wires>::materialize() const
+{
+    BasicSequentialCircuit<Wires> circuit;
+    for (uint8_t l = 0; l < layers.size(); l++)
+    {
+        BasicLayer<Wires>& layer = circuit.layers.emplace_back();
+        layer.gates.assign(layerGates(l), layerGates(l) + layers[l].size);
+        layer.inputOffset = layers[l].inputOffset;
+        layer.gateOffset = layers[l].gateOffset;
+    }
+    return circuit;
+}
+
+
+
+
+// activation truth table with input, output and dont care columns,
+// gate activation columns are left to be computed
+template<typename Wires>
+static ActivationTruthTable transposeTruthTable(
+    uint16_t nInputs,
+    uint16_t nWires,
+    uint16_t nOutputs,
+    const BasicTruthTable<Wires>& truthTable
 ) {
-    std::vector<std::pair<uint64_t, uint64_t>> tt(truthTable.entries.size());
-    for (uint64_t i = 0; i < tt.size(); i++)
+    ActivationTruthTable att;
+    att.rows  = truthTable.entries.size();
+    att.words = (att.rows + 63) / 64;
+    att.activations.resize(att.words * nWires);
+    att.outputs.resize(att.words * nOutputs);
+    att.dontCares.resize(att.words * nOutputs);
+
+    // mark padding rows of the last word as dont care
+    if (att.rows % 64)
+        for (uint16_t o = 0; o < nOutputs; o++)
+            att.dontCares[o * att.words + att.words - 1] = ~0ul << (att.rows % 64);
+
+    // transpose input, output and dont care bits into columns
+    for (uint64_t i = 0; i < att.rows; i++)
     {
-        // write input bits
-        tt[i].first = truthTable.entries[i].inputBits;
+        const auto& entry = truthTable.entries[i];
+        const uint64_t word = i / 64;
+        const uint64_t bit  = 1ul << (i % 64);
+
+        for (uint16_t w = 0; w < nInputs; w++)
+            if (testWire(entry.inputBits, w)) 
+                att.activations[w * att.words + word] |= bit;
         
-        // write gate activation bits
-        for (uint8_t l = 1; l < circuit.layers.size() - 1; l++)
+        for (uint16_t o = 0; o < nOutputs; o++)
         {
-            const SequentialCircuit::Layer& layer = circuit.layers[l];
-            for (uint8_t g = 0; g < layer.gates.size(); g++)
-                tt[i].first |= layer.gates[g].getActivation(tt[i].first) << (layer.gateOffset + g);
+            if (testWire(entry.outputBits, o))   att.outputs[o * att.words + word]   |= bit;
+            if (testWire(entry.dontCareBits, o)) att.dontCares[o * att.words + word] |= bit;
         }
-        
-        // write output bits
-        tt[i].first |= truthTable.entries[i].outputBits << circuit.layers.back().gateOffset;
-    
-        // write dont care bits
-        tt[i].second = truthTable.entries[i].dontCareBits << circuit.layers.back().gateOffset;
     }
 
-    return tt;
+    return att;
+}
+
+template<typename Wires>
+ActivationTruthTable logic::computeActivationTruthTable(
+    const BasicSequentialCircuit<Wires>& circuit,
+    const BasicTruthTable<Wires>& truthTable
+) {
+    ActivationTruthTable att = transposeTruthTable(circuit.layers.front().gates.size(), 
+        circuit.layers.back().gateOffset, circuit.layers.back().gates.size(), truthTable);
+
+    // write gate activation columns
+    updateActivationTruthTable(circuit, att, 1);
+
+    return att;
+}
+
+template<typename Wires>
+ActivationTruthTable logic::computeActivationTruthTable(
+    const BasicFlatCircuit<Wires>& circuit,
+    const BasicTruthTable<Wires>& truthTable
+) {
+    ActivationTruthTable att = transposeTruthTable(circuit.layers.front().size, 
+        circuit.layers.back().gateOffset, circuit.layers.back().size, truthTable);
+
+    for (uint8_t l = 1; l < circuit.layers.size() - 1; l++)
+        updateLayerActivations(circuit, l, att);
+
+    return att;
 }
 
 
 
 
+template<typename Wires>
 void logic::updateActivationTruthTable(
-    const SequentialCircuit& circuit,
+    const BasicSequentialCircuit<Wires>& circuit,
     ActivationTruthTable& activationTruthTable,
     uint8_t layerIndex
 ) {
     for (uint8_t l = layerIndex; l < circuit.layers.size() - 1; l++)
+        updateLayerActivations(circuit.layers[l], activationTruthTable);
+}
+
+// lowest wire of an input mask and the mask relative to it, the
+// kernels take masks of up to 64 wires, false if the mask spans more
+template<typename Wires>
+static bool kernelMask(const Wires& inputMask, uint16_t& base, uint64_t& mask)
+{
+    if constexpr (wireCapacity<Wires> == 64)
+    {
+        base = 0;
+        mask = inputMask;
+        return true;
+    }
+    else
+    {
+        base = lowestWire(inputMask);
+        mask = lowWord(inputMask >> base);
+        return wireWidth(inputMask) - base <= 64;
+    }
+}
+
+template<typename Wires>
+static void updateGateActivations(
+    const BasicGate<Wires>* gates,
+    uint8_t size,
+    uint16_t gateOffset,
+    ActivationTruthTable& activationTruthTable
+) {
+    // vector kernels only pay off from a full vector of words
+    const kernels::Kernels& k = kernels::active();
+    const bool vectorized = k.level != kernels::Level::SCALAR and activationTruthTable.words >= k.width;
+
+    for (uint8_t g = 0; g < size; g++)
+    {
+        uint64_t* column = activationTruthTable.wire(gateOffset + g);
+        uint16_t base;
+        uint64_t mask;
+        if (vectorized and kernelMask(gates[g].inputMask, base, mask))
+            k.gateActivations(activationTruthTable.wire(base), activationTruthTable.words,
+                              mask, gates[g].mode, column);
+        else
+            for (uint64_t w = 0; w < activationTruthTable.words; w++)
+                column[w] = gates[g].getActivation(activationTruthTable, w);
+    }
+}
+
+template<typename Wires>
+void logic::updateLayerActivations(
+    const BasicLayer<Wires>& layer,
+    ActivationTruthTable& activationTruthTable
+) {
+    updateGateActivations(layer.gates.data(), layer.gates.size(), layer.gateOffset, activationTruthTable);
+}
+
+template<typename Wires>
+void logic::updateLayerActivations(
+    const BasicFlatCircuit<Wires>& circuit,
+    uint8_t layerIndex,
+    ActivationTruthTable& activationTruthTable
+) {
+    const auto& layer = circuit.layers[layerIndex];
+    updateGateActivations(circuit.layerGates(layerIndex), layer.size, layer.gateOffset, activationTruthTable);
+}
+
+
+
+
+// bit of a mode in mode masks, and the modes sharing the activation
+// of a base mode, inverted modes are the complement of their base
+static constexpr uint8_t modeBit(GateMode mode) { return 1 << uint8_t(mode); }
+static constexpr uint8_t baseModes(GateMode base) { return modeBit(base) | modeBit(GateMode(uint8_t(base) | 0b100)); }
+
+template<GateMode... Modes>
+static constexpr uint8_t modeSet = (modeBit(Modes) | ... | 0);
+
+static constexpr uint8_t allModeBits = modeSet<
+    GateMode::AND, GateMode::OR, GateMode::XOR, GateMode::NAND, GateMode::NOR, GateMode::XNOR>;
+
+static uint8_t modeMask(const std::vector<GateMode>& modes)
+{
+    uint8_t mask = 0;
+    for (auto m : modes) mask |= modeBit(m);
+    return mask;
+}
+
+
+// rows of 64 in which the activations of the modes of an input mask
+// differ from the target, columns of the inputs stride words apart,
+// only the activations of the base modes of the mode set are computed
+template<uint8_t Modes = allModeBits>
+struct ModeDiffs
+{
+    static constexpr bool needAnd = Modes & baseModes(GateMode::AND);
+    static constexpr bool needOr  = Modes & baseModes(GateMode::OR);
+    static constexpr bool needXor = Modes & baseModes(GateMode::XOR);
+
+    uint64_t andDiff = 0, orDiff = 0, xorDiff = 0, care;
+
+    ModeDiffs(const uint64_t* columns, uint64_t stride, uint64_t inputMask, uint64_t target, uint64_t care) :
+        care(care)
     {
-        auto& layer = circuit.layers[l];
-        for (auto& [activation, _] : activationTruthTable)
+        // compute the mode activations for 64 rows simultaneously
+        uint64_t andActivation = ~0ul, orActivation = 0, xorActivation = 0;
+        for (; inputMask; inputMask &= inputMask - 1)
         {
-            for (uint8_t g = 0; g < layer.gates.size(); g++)
-            {
-                activation &= ~(1ul << (layer.gateOffset + g));
-                activation |= layer.gates[g].getActivation(activation) << (layer.gateOffset + g);
-            }
+            uint64_t activation = columns[__builtin_ctzll(inputMask) * stride];
+            if constexpr (needAnd) andActivation &= activation;
+            if constexpr (needOr)  orActivation  |= activation;
+            if constexpr (needXor) xorActivation ^= activation;
         }
+        if constexpr (needAnd) andDiff = (andActivation ^ target) & care;
+        if constexpr (needOr)  orDiff  = (orActivation  ^ target) & care;
+        if constexpr (needXor) xorDiff = (xorActivation ^ target) & care;
+    }
+
+    // rows differing for a mode, inverted modes differ in the others
+    uint64_t rows(GateMode mode) const
+    {
+        const uint8_t base = uint8_t(mode) & 0b011;
+        const uint64_t diff = base == uint8_t(GateMode::AND) ? andDiff : base == uint8_t(GateMode::OR) ? orDiff : xorDiff;
+        return uint8_t(mode) & 0b100 ? care & ~diff : diff;
+    }
+
+    // modes of the set differing in any cared row
+    uint8_t failed() const
+    {
+        using enum GateMode;
+        uint8_t failed = 0;
+        if constexpr (bool(Modes & modeBit(AND)))  failed |= uint8_t(andDiff != 0)    << uint8_t(AND);
+        if constexpr (bool(Modes & modeBit(OR)))   failed |= uint8_t(orDiff  != 0)    << uint8_t(OR);
+        if constexpr (bool(Modes & modeBit(XOR)))  failed |= uint8_t(xorDiff != 0)    << uint8_t(XOR);
+        if constexpr (bool(Modes & modeBit(NAND))) failed |= uint8_t(andDiff != care) << uint8_t(NAND);
+        if constexpr (bool(Modes & modeBit(NOR)))  failed |= uint8_t(orDiff  != care) << uint8_t(NOR);
+        if constexpr (bool(Modes & modeBit(XNOR))) failed |= uint8_t(xorDiff != care) << uint8_t(XNOR);
+        return failed;
+    }
+};
+
+
+// tables of fewer words scan their full columns about as fast 
+// as the killer rows are gathered
+static constexpr uint64_t killerMinWords = 8;
+
+// write the bits of the row in a slot of the killer rows
+static void gatherKillerRow(
+    KillerRows& killers,
+    uint8_t slot,
+    const ActivationTruthTable& att,
+    uint16_t inputOffset,
+    uint8_t size
+) {
+    const uint64_t word = killers.rows[slot] / 64, shift = killers.rows[slot] % 64;
+    const uint64_t bit = 1ul << slot;
+
+    for (uint16_t v = 0; v < killers.visible.size(); v++)
+        killers.visible[v] = (killers.visible[v] & ~bit) | (att.wire(inputOffset + v)[word] >> shift & 1) << slot;
+    for (uint8_t o = 0; o < size; o++)
+    {
+        killers.outputs[o] = (killers.outputs[o] & ~bit) | (att.output(o)[word] >> shift & 1) << slot;
+        killers.cares[o] = (killers.cares[o] & ~bit) | (~att.dontCare(o)[word] >> shift & 1) << slot;
+    }
+}
+
+// gather the killer rows of the current activations
+static void gatherKillerRows(
+    KillerRows& killers,
+    const ActivationTruthTable& att,
+    uint16_t inputOffset,
+    uint16_t nVisible,
+    uint8_t size
+) {
+    if (std::any_of(killers.rows.begin(), killers.rows.end(), [&](uint64_t r) { return r >= att.rows; }))
+    {
+        killers.rows.clear();
+        killers.next = 0;
     }
+
+    killers.visible.assign(nVisible, 0);
+    killers.outputs.assign(size, 0);
+    killers.cares.assign(size, 0);
+    for (uint8_t slot = 0; slot < killers.rows.size(); slot++)
+        gatherKillerRow(killers, slot, att, inputOffset, size);
 }
 
+// keep the first row rejecting each of the mode options of an input
+// mask, in place of the oldest killer rows once all slots are taken
+static void rememberKillerRows(
+    KillerRows& killers,
+    uint64_t inputMask,
+    uint8_t modeOptions,
+    const ActivationTruthTable& att,
+    uint16_t inputOffset,
+    uint8_t pos,
+    uint8_t size
+) {
+    const uint64_t* visible = att.wire(inputOffset);
+    for (uint64_t w = 0; w < att.words and modeOptions; w++)
+    {
+        ModeDiffs<> diffs(visible + w, att.words, inputMask, att.output(pos)[w], ~att.dontCare(pos)[w]);
+        for (uint8_t failed = modeOptions & diffs.failed(); failed; failed &= failed - 1)
+        {
+            const uint64_t row = w * 64 + __builtin_ctzll(diffs.rows(GateMode(__builtin_ctz(failed))));
+            if (std::find(killers.rows.begin(), killers.rows.end(), row) != killers.rows.end())
+                continue;
 
+            uint8_t slot = killers.rows.size();
+            if (slot < KillerRows::capacity)
+                killers.rows.push_back(row);
+            else
+            {
+                slot = killers.next;
+                killers.next = (killers.next + 1) % KillerRows::capacity;
+                killers.rows[slot] = row;
+            }
+            gatherKillerRow(killers, slot, att, inputOffset, size);
+        }
+        modeOptions &= ~diffs.failed();
+    }
+}
 
 
-bool logic::tryConstructOutputLayer(
-    SequentialCircuit& circuit, 
+// output gates of the modes of the mask, which are a subset of the
+// compile-time mode set Modes, the scalar checks evaluate only the 
+// base modes of the set without branching on the modes per gate
+template<typename Wires, uint8_t Modes>
+static bool constructOutputGates(
+    BasicGate<Wires>* gates,
+    uint8_t size,
+    uint16_t inputOffset,
+    uint16_t gateOffset,
     const ActivationTruthTable& activationTruthTable, 
-    const std::vector<SequentialCircuit::Gate::Mode> modes
+    uint8_t modes,
+    SearchStats* stats,
+    const CostModel* cost,
+    KillerRows* killers
 ) {
-    uint8_t allModes = 0;
-    for (auto m : modes) allModes |= 1 << (uint8_t)m;
-
-    const uint64_t maskInc = 1ul << circuit.layers.back().inputOffset;
-    const uint64_t maskTop = 1ul << circuit.layers.back().gateOffset;
-    uint64_t       pos     = 1ul << circuit.layers.back().gateOffset;
-    for (auto& gate : circuit.layers.back().gates)
+    const uint8_t allModes = modes & Modes;
+
+    // lowest mode cost, bounds the cost of the gates of an input mask
+    double modeCost = INFINITY;
+    if (cost)
+        for (uint8_t m = allModes; m; m &= m - 1)
+            modeCost = std::min(modeCost, cost->modes[__builtin_ctz(m)]);
+
+    const ActivationTruthTable& att = activationTruthTable;
+    const kernels::Kernels& k = kernels::active();
+    const bool vectorized = k.level != kernels::Level::SCALAR and att.words >= k.width;
+
+    // output gates checked against the rows and rows scanned, counted
+    // locally as the gates written may alias the counters
+    uint64_t candidates = 0, rows = 0;
+    auto count = [&]()
+    {
+        if (!stats) return;
+        stats->outputCandidates += candidates;
+        stats->rowsScanned += rows;
+    };
+
+    // input masks of the wires visible to the output layer,
+    // relative to its input offset
+    if (gateOffset - inputOffset >= 64)
+        throw std::overflow_error("Output layer connections exceed the 64 bit index range.");
+    const uint64_t* visible = att.wire(inputOffset);
+    const uint64_t maskTop = 1ul << (gateOffset - inputOffset);
+
+    // candidates are checked against the killer rows first
+    if (att.words < killerMinWords)
+        killers = nullptr;
+    if (killers)
+        gatherKillerRows(*killers, att, inputOffset, gateOffset - inputOffset, size);
+
+    for (uint8_t pos = 0; pos < size; pos++)
     {
-        for (gate.inputMask = maskInc; gate.inputMask < maskTop; gate.inputMask += maskInc)
+        BasicGate<Wires>& gate = gates[pos];
+        const uint64_t* target   = att.output(pos);
+        const uint64_t* dontCare = att.dontCare(pos);
+
+        // cheapest gate found for the position with a cost model
+        double bestCost = INFINITY;
+
+        for (uint64_t inputMask = 1; inputMask < maskTop; inputMask++)
         {
+            const unsigned inputs = __builtin_popcountll(inputMask);
+            if (cost and cost->gate + cost->input * inputs + modeCost >= bestCost)
+                continue;
+
+            candidates++;
+
             uint8_t modeOptions = allModes;
-            for (auto [activation, dontCare] : activationTruthTable)
+            if (killers and !killers->rows.empty())
             {
-                if (dontCare & pos) continue;
-
-                using enum SequentialCircuit::Gate::Mode;
-
-                // compute all mode activations simultaneously and 
-                // keep track of wether one is suitable with the 
-                // given input mask
-                uint64_t maskedActivation = activation & gate.inputMask;
-                uint8_t modeActivations = 
-                    (uint8_t(maskedActivation == gate.inputMask)  << uint8_t(AND)) |
-                    (uint8_t(maskedActivation > 0)                << uint8_t(OR))  |
-                    (uint8_t(__builtin_parityll(maskedActivation) << uint8_t(XOR)));
-                modeActivations |= (~modeActivations) << 4;
-                
-                // keep 1 in mode option if mode activation matches desired activation
-                modeOptions &= (activation & pos) ? modeActivations : ~modeActivations;
+                modeOptions &= ~ModeDiffs<Modes>(killers->visible.data(), 1, inputMask, 
+                    killers->outputs[pos], killers->cares[pos]).failed();
+                if (!modeOptions)
+                {
+                    rows += killers->rows.size();
+                    continue;
+                }
+            }
+            rows += att.rows;
 
+            const uint8_t remaining = modeOptions;
+            if (vectorized)
+                modeOptions = k.modeOptions(visible, att.words, inputMask, target, dontCare, modeOptions);
+            else for (uint64_t w = 0; w < att.words; w++)
+            {
+                // keep 1 in mode option if mode activations match 
+                // desired activations in all rows that are cared for
+                modeOptions &= ~ModeDiffs<Modes>(visible + w, att.words, inputMask, target[w], ~dontCare[w]).failed();
                 if (!modeOptions) break;
             }
 
+            // rows rejecting the candidate are found by a second scan,
+            // rare once the killer rows reject most candidates
+            if (killers and !modeOptions)
+                rememberKillerRows(*killers, inputMask, remaining, att, inputOffset, pos, size);
+
             // getting here either there are no more mode options for this
             // position, or the truth table was fully traversed with mode
             // options remaining (position done)
-            if (modeOptions)
+            if (modeOptions and !cost)
             {
                 // get first mode that persisted in mode options
-                gate.mode = (SequentialCircuit::Gate::Mode)__builtin_popcountll(~modeOptions & (modeOptions - 1));
+                gate.inputMask = Wires(inputMask) << inputOffset;
+                gate.mode = (GateMode)__builtin_popcountll(~modeOptions & (modeOptions - 1));
                 goto next_pos;
             }
+
+            // keep the cheapest mode that persisted in mode options
+            for (; modeOptions; modeOptions &= modeOptions - 1)
+            {
+                GateMode mode = (GateMode)__builtin_ctz(modeOptions);
+                if (cost->gateCost(mode, inputs) < bestCost)
+                {
+                    bestCost = cost->gateCost(mode, inputs);
+                    gate.inputMask = Wires(inputMask) << inputOffset;
+                    gate.mode = mode;
+                }
+            }
         }
 
+        if (bestCost < INFINITY)
+            continue;
+
         // getting here means all options for this position failed
+        count();
         return false;
 
-    next_pos:
-        pos <<= 1;
+    next_pos:;
     }
 
     // getting here means a gate was found for all output positions
+    count();
     return true;
 }
+
+// modes of the bases of a set, bit 0 for AND, 1 for OR and 2 for XOR,
+// and their inversions, a kernel computes the activations of the bases
+static constexpr uint8_t baseModeSet(uint8_t bases)
+{
+    using enum GateMode;
+    return (bases & 1 ? baseModes(AND) : 0) | (bases & 2 ? baseModes(OR) : 0) | (bases & 4 ? baseModes(XOR) : 0);
+}
+
+template<typename Wires, size_t... Bases>
+static constexpr std::array<OutputGatesKernel<Wires>, sizeof...(Bases)> outputGatesKernels(std::index_sequence<Bases...>)
+{
+    return { constructOutputGates<Wires, baseModeSet(Bases)>... };
+}
+
+// instantiation of the bases of the modes, every mode set runs in the 
+// one of the mode set of its bases, other modes of which are masked
+template<typename Wires>
+static OutputGatesKernel<Wires> outputGatesKernel(uint8_t modes)
+{
+    using enum GateMode;
+    static constexpr auto kernels = outputGatesKernels<Wires>(std::make_index_sequence<8>());
+    return kernels[
+        uint8_t(bool(modes & baseModes(AND)))      |
+        uint8_t(bool(modes & baseModes(OR)))  << 1 |
+        uint8_t(bool(modes & baseModes(XOR))) << 2];
+}
+
+template<typename Wires>
+bool logic::tryConstructOutputLayer(
+    BasicSequentialCircuit<Wires>& circuit, 
+    const ActivationTruthTable& activationTruthTable, 
+    const std::vector<GateMode> modes
+) {
+    BasicLayer<Wires>& layer = circuit.layers.back();
+    const uint8_t mask = modeMask(modes);
+    return outputGatesKernel<Wires>(mask)(layer.gates.data(), layer.gates.size(), 
+        layer.inputOffset, layer.gateOffset, activationTruthTable, mask, nullptr, nullptr, nullptr);
+}
+
+template<typename Wires>
+bool logic::tryConstructOutputLayer(
+    BasicFlatCircuit<Wires>& circuit, 
+    const ActivationTruthTable& activationTruthTable, 
+    const std::vector<GateMode>& modes,
+    SearchStats* stats,
+    const CostModel* cost,
+    KillerRows* killers
+) {
+    const auto& layer = circuit.layers.back();
+    const uint8_t mask = modeMask(modes);
+    return outputGatesKernel<Wires>(mask)(circuit.layerGates(circuit.layers.size() - 1), layer.size, 
+        layer.inputOffset, layer.gateOffset, activationTruthTable, mask, stats, cost, killers);
+}
+
+
+bool logic::selfTestOutputGates(const TruthTable& truthTable)
+{
+    const uint8_t nInputs  = std::max<uint8_t>(1, truthTable.inputWidth());
+    const uint8_t nOutputs = std::max<uint8_t>(1, truthTable.outputWidth());
+
+    // costs preferring other gates than the first found
+    CostModel cost;
+    cost.input = 0.5;
+    for (uint8_t m = 0; m < 8; m++) cost.modes[m] = 8 - m;
+
+    // each output and its inversion by itself, as single gates are found
+    // more often than layers of all outputs, with the table rows repeated
+    // to be checked against killer rows
+    bool passed = true;
+    for (uint16_t o = 0; o < 2 * nOutputs; o++)
+    {
+        TruthTable output, repeated;
+        for (auto& entry : truthTable.entries)
+            output.entries.push_back({ entry.inputBits, (entry.outputBits >> o / 2 ^ o) & 1, entry.dontCareBits >> o / 2 & 1 });
+        for (uint64_t r = 0; repeated.entries.size() < 64 * killerMinWords + 5 and !output.entries.empty(); r++)
+            repeated.entries.push_back(output.entries[r % output.entries.size()]);
+
+        for (const TruthTable* tt : std::array<const TruthTable*, 2>{ &output, &repeated })
+        {
+            BasicFlatCircuit<uint64_t> circuit({ nInputs, 1 }, true);
+            ActivationTruthTable att = computeActivationTruthTable(circuit, *tt);
+            const auto& layer = circuit.layers.back();
+
+            for (unsigned modes = 1; modes <= allModeBits; modes++)
+            {
+                if (modes & ~allModeBits) continue;
+                for (const CostModel* c : std::array<const CostModel*, 2>{ nullptr, &cost })
+                {
+                    BasicGate<uint64_t> expected{ 0, GateMode::IN }, gate{ 0, GateMode::IN };
+                    KillerRows expectedKillers, killers;
+                    bool found = constructOutputGates<uint64_t, allModeBits>(&expected, 1,
+                        layer.inputOffset, layer.gateOffset, att, modes, nullptr, c, &expectedKillers);
+                    bool constructed = outputGatesKernel<uint64_t>(modes)(&gate, 1,
+                        layer.inputOffset, layer.gateOffset, att, modes, nullptr, c, &killers);
+
+                    passed = passed and found == constructed and 
+                        (!found or (expected.inputMask == gate.inputMask and expected.mode == gate.mode));
+                }
+            }
+        }
+    }
+    return passed;
+}
+
+
+
+
+#define INSTANTIATE(Wires) \
+    template struct logic::BasicGate<Wires>; \
+    template struct logic::BasicFlatCircuit<Wires>; \
+    template struct logic::BasicSequentialCircuit<Wires>; \
+    template void logic::selectDistinctFirstLayers(LayerBuilder&, const BasicTruthTable<Wires>&, bool, const SolveOptions&); \
+    template void logic::orderFirstLayers(LayerBuilder&, const BasicTruthTable<Wires>&, bool); \
+    template ActivationTruthTable logic::computeActivationTruthTable(const BasicSequentialCircuit<Wires>&, const BasicTruthTable<Wires>&); \
+    template ActivationTruthTable logic::computeActivationTruthTable(const BasicFlatCircuit<Wires>&, const BasicTruthTable<Wires>&); \
+    template void logic::updateActivationTruthTable(const BasicSequentialCircuit<Wires>&, ActivationTruthTable&, uint8_t); \
+    template void logic::updateLayerActivations(const BasicLayer<Wires>&, ActivationTruthTable&); \
+    template void logic::updateLayerActivations(const BasicFlatCircuit<Wires>&, uint8_t, ActivationTruthTable&); \
+    template bool logic::tryConstructOutputLayer(BasicSequentialCircuit<Wires>&, const ActivationTruthTable&, const std::vector<GateMode>); \
+    template bool logic::tryConstructOutputLayer(BasicFlatCircuit<Wires>&, const ActivationTruthTable&, const std::vector<GateMode>&, SearchStats*, const CostModel*, KillerRows*);
+LOGIC_FOR_EACH_WIRES(INSTANTIATE)
+#undef INSTANTIATE
@@ -0,0 +1,379 @@
+#include "sequentialCircuit.h"
+#include <iostream>
+#include <algorithm>
+#include <math.h>
+#include <random>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <numeric>
+
+using namespace logic;
+
+
+
+
+// annealing schedule of a restart, moves scale with the mutable
+// gates, temperatures are in mismatched bits per table row
+static constexpr uint64_t movesPerGate     = 20000;
+static constexpr double   startTemperature = 0.05;
+static constexpr double   endTemperature   = 0.002;
+
+
+// circuit under mutation with its activation columns and the
+// mismatched cared bits of each output gate, a move mutates one
+// gate, recomputes the columns of its downstream cone and is
+// undone by restoring the gate and the columns it overwrote
+template<typename Wires>
+struct AnnealingState
+{
+    using Gate = BasicGate<Wires>;
+    using FlatCircuit = BasicFlatCircuit<Wires>;
+
+    const std::vector<GateMode>& modes;
+    FlatCircuit circuit;
+    ActivationTruthTable att;
+
+    std::vector<uint8_t> layerOf;       // layer of each wire and output gate
+    uint16_t nInputs;
+    uint16_t outputOffset;
+
+    std::vector<uint64_t> mismatches;   // per output gate
+    uint64_t score = 0;
+
+    // undo log of the last move
+    uint16_t mutated = 0;
+    Gate previous;
+    uint64_t previousScore = 0;
+    std::vector<uint16_t> undoWires;
+    std::vector<uint64_t> undoColumns;
+    std::vector<std::pair<uint16_t, uint64_t>> undoMismatches;
+
+    // scratch column of the recomputed gate
+    std::vector<uint64_t> column;
+
+    AnnealingState(
+        const std::vector<uint8_t>& layerSizes,
+        const BasicTruthTable<Wires>& truthTable,
+        const std::vector<GateMode>& modes,
+        bool balanced
+    ) :
+        modes(modes),
+        circuit(layerSizes, balanced),
+        nInputs(layerSizes.front()),
+        outputOffset(circuit.layers.back().gateOffset)
+    {
+        for (uint8_t l = 0; l < circuit.layers.size(); l++)
+            layerOf.resize(layerOf.size() + circuit.layers[l].size, l);
+
+        att = computeActivationTruthTable(circuit, truthTable);
+        mismatches.resize(circuit.layers.back().size);
+        column.resize(att.words);
+    }
+
+    // wires a gate may take as inputs, [begin, end)
+    uint16_t inputBegin(uint16_t wire) const { return circuit.layers[layerOf[wire]].inputOffset; }
+    uint16_t inputEnd(uint16_t wire)   const { return circuit.layers[layerOf[wire]].gateOffset; }
+
+    uint64_t countMismatches(uint16_t output) const
+    {
+        const Gate& gate = circuit.gates[outputOffset + output];
+        const uint64_t* target = att.output(output);
+        const uint64_t* dontCare = att.dontCare(output);
+
+        uint64_t count = 0;
+        for (uint64_t w = 0; w < att.words; w++)
+            count += __builtin_popcountll((gate.getActivation(att, w) ^ target[w]) & ~dontCare[w]);
+        return count;
+    }
+
+    // gates of random modes with up to three random inputs each
+    void randomize(std::mt19937_64& rng)
+    {
+        for (uint16_t wire = nInputs; wire < circuit.gates.size(); wire++)
+        {
+            const uint16_t begin = inputBegin(wire), end = inputEnd(wire);
+            const unsigned fanIn = std::min<unsigned>(end - begin, 1 + rng() % 3);
+
+            Gate& gate = circuit.gates[wire];
+            gate.mode = modes[rng() % modes.size()];
+            gate.inputMask = 0;
+            while (wireCount(gate.inputMask) < fanIn)
+                gate.inputMask |= wireBit<Wires>(begin + rng() % (end - begin));
+        }
+
+        for (uint8_t l = 1; l < circuit.layers.size() - 1; l++)
+            updateLayerActivations(circuit, l, att);
+
+        score = 0;
+        for (uint16_t o = 0; o < mismatches.size(); o++)
+            score += mismatches[o] = countMismatches(o);
+    }
+
+    // recompute the column of a hidden gate, logging the old column
+    bool recompute(uint16_t wire)
+    {
+        uint64_t* activations = att.wire(wire);
+        for (uint64_t w = 0; w < att.words; w++)
+            column[w] = circuit.gates[wire].getActivation(att, w);
+        if (std::equal(column.begin(), column.end(), activations))
+            return false;
+
+        undoWires.push_back(wire);
+        undoColumns.insert(undoColumns.end(), activations, activations + att.words);
+        std::copy(column.begin(), column.end(), activations);
+        return true;
+    }
+
+    // toggle or replace an input or change the mode of a random gate,
+    // return false without a change if the move would leave no inputs
+    bool move(std::mt19937_64& rng)
+    {
+        const uint16_t wire = nInputs + rng() % (circuit.gates.size() - nInputs);
+        Gate& gate = circuit.gates[wire];
+
+        mutated = wire;
+        previous = gate;
+        previousScore = score;
+        undoWires.clear();
+        undoColumns.clear();
+        undoMismatches.clear();
+
+        if (modes.size() > 1 and rng() % 3 == 0)
+        {
+            GateMode mode = modes[rng() % (modes.size() - 1)];
+            gate.mode = mode == gate.mode ? modes.back() : mode;
+        }
+        else
+        {
+            const uint16_t begin = inputBegin(wire), end = inputEnd(wire);
+            const Wires toggled = wireBit<Wires>(begin + rng() % (end - begin));
+
+            // half the added inputs replace a random input
+            if (!(gate.inputMask & toggled) and rng() % 2)
+            {
+                Wires inputs = gate.inputMask;
+                for (unsigned i = rng() % wireCount(inputs); i; i--)
+                    clearLowestWire(inputs);
+                gate.inputMask ^= wireBit<Wires>(lowestWire(inputs));
+            }
+
+            gate.inputMask ^= toggled;
+            if (!gate.inputMask)
+            {
+                gate = previous;
+                return false;
+            }
+        }
+
+        // wires whose column changed, gates of later layers only read
+        // wires of earlier layers, so wire order is a topological order
+        Wires changed = 0;
+        if (wire < outputOffset)
+        {
+            if (!recompute(wire))
+                return true;
+            changed = wireBit<Wires>(wire);
+
+            for (uint16_t w = wire + 1; w < outputOffset; w++)
+                if ((circuit.gates[w].inputMask & changed) and recompute(w))
+                    changed |= wireBit<Wires>(w);
+        }
+
+        for (uint16_t o = 0; o < mismatches.size(); o++)
+            if (outputOffset + o == wire or (circuit.gates[outputOffset + o].inputMask & changed))
+            {
+                undoMismatches.push_back({ o, mismatches[o] });
+                mismatches[o] = countMismatches(o);
+                score += mismatches[o] - undoMismatches.back().second;
+            }
+        return true;
+    }
+
+    void undo()
+    {
+        circuit.gates[mutated] = previous;
+        score = previousScore;
+        for (uint64_t i = 0; i < undoWires.size(); i++)
+            std::copy(undoColumns.begin() + i * att.words, undoColumns.begin() + (i + 1) * att.words, att.wire(undoWires[i]));
+        for (auto [o, count] : undoMismatches)
+            mismatches[o] = count;
+    }
+};
+
+
+
+
+template<typename Wires>
+LocalSearchResult<Wires> BasicSequentialCircuit<Wires>::solveLocal(
+    std::vector<uint8_t> layerSizes,
+    const TruthTable& truthTable,
+    std::vector<GateMode> modes,
+    bool balanced,
+    const SolveOptions& options
+) {
+    if (layerSizes.size() < 2)
+        throw std::invalid_argument("Solver expects at least input and output layer sizes.");
+    if (std::find(layerSizes.begin(), layerSizes.end(), 0) != layerSizes.end())
+        throw std::invalid_argument("Solver expects layer sizes to be greater 0");
+    if (modes.empty())
+        throw std::invalid_argument("Local search expects at least one gate mode.");
+
+    // search with the narrowest wire state holding all wires
+    const uint16_t nWires = std::reduce(layerSizes.begin(), layerSizes.end() - 1, 0);
+    const uint16_t width  = std::max<uint16_t>(nWires, layerSizes.back());
+    if (width > wireCapacity<Wires>)
+        throw std::overflow_error("Circuit wires exceed the " + std::to_string(wireCapacity<Wires>) + " bit wire state.");
+
+    if constexpr (wireCapacity<Wires> > 64)
+        if (width <= wireCapacity<Wires> / 2)
+        {
+            auto half = BasicSequentialCircuit<HalfWires<Wires>>::solveLocal(layerSizes, 
+                truthTable.template convert<HalfWires<Wires>>(), modes, balanced, options);
+            return { half.circuit.template convert<Wires>(), half.mismatches };
+        }
+
+    std::sort(modes.begin(), modes.end());
+    const TruthTable table = truthTable.compacted(layerSizes.back());
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(options.localSeconds));
+
+
+    // independent restarts on all threads until the time budget is
+    // spent or a circuit satisfies the table, keeping the best circuit
+
+    const unsigned nThreads = options.threads ? options.threads :
+        std::max(1u, std::thread::hardware_concurrency());
+
+    LocalSearchResult<Wires> best;
+    best.mismatches = UINT64_MAX;
+    std::atomic<bool> solved = false;
+    std::atomic<uint64_t> restarts = 0;
+    SearchStats stats;
+    std::mutex mutex;
+
+    // progress is printed by the first thread
+    const auto reportInterval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(options.progressInterval));
+    auto nextReport = start;
+
+    auto report = [&]()
+    {
+        std::cout << "\rlocal search restarts: " << restarts << ", best mismatches: " << best.mismatches << "   " << std::flush;
+    };
+
+    auto worker = [&](unsigned thread)
+    {
+        SearchStats threadStats;
+        std::seed_seq seed{ options.seed, uint64_t(thread) };
+        std::mt19937_64 rng(seed);
+        std::uniform_real_distribution<double> uniform;
+
+        AnnealingState<Wires> state(layerSizes, table, modes, balanced);
+        const uint64_t nMoves = movesPerGate * (state.circuit.gates.size() - state.nInputs);
+        const double rows = std::max<uint64_t>(1, table.entries.size());
+        const double cooling = pow(endTemperature / startTemperature, 1.0 / nMoves);
+
+        // circuits improving on the best of the restart are compared
+        // with the best of all restarts
+        uint64_t restartBest;
+        auto keep = [&]()
+        {
+            if (state.score >= restartBest) return;
+            restartBest = state.score;
+
+            std::lock_guard lock(mutex);
+            if (state.score < best.mismatches)
+            {
+                best.mismatches = state.score;
+                best.circuit = state.circuit.materialize();
+            }
+        };
+
+        bool expired = false;
+        while (!expired and !solved)
+        {
+            restarts++;
+            threadStats.localRestarts++;
+            state.randomize(rng);
+            restartBest = UINT64_MAX;
+            keep();
+
+            double temperature = startTemperature * rows;
+            for (uint64_t m = 0; m < nMoves and state.score; m++, temperature *= cooling)
+            {
+                if ((m & 0x3ff) == 0)
+                {
+                    const auto now = std::chrono::steady_clock::now();
+                    if (now >= deadline or solved)
+                    {
+                        expired = now >= deadline;
+                        break;
+                    }
+                    if (options.progress and thread == 0 and now >= nextReport)
+                    {
+                        std::lock_guard lock(mutex);
+                        nextReport = now + reportInterval;
+                        report();
+                    }
+                }
+
+                threadStats.localMoves++;
+                if (!state.move(rng))
+                    continue;
+
+                // worse circuits are accepted with falling probability
+                const uint64_t previousScore = state.previousScore;
+                if (state.score > previousScore and uniform(rng) >= exp((double(previousScore) - state.score) / temperature))
+                    state.undo();
+                else
+                    keep();
+            }
+
+            if (state.score == 0)
+                solved = true;
+        }
+
+        std::lock_guard lock(mutex);
+        stats += threadStats;
+    };
+
+    if (nThreads == 1)
+        worker(0);
+    else
+    {
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < nThreads; t++)
+            threads.emplace_back(worker, t);
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    if (options.progress)
+    {
+        report();
+        std::cout << std::endl;
+    }
+
+    // a solution must satisfy the table before compacting
+    if (best.mismatches == 0 and !best.circuit.satisfies(truthTable))
+        throw std::logic_error("Local search solution does not satisfy the truth table.");
+
+    stats.searchSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (options.stats)
+        *options.stats += stats;
+
+    return best;
+}
+
+
+
+
+#define INSTANTIATE(Wires) \
+    template LocalSearchResult<Wires> BasicSequentialCircuit<Wires>::solveLocal( \
+        std::vector<uint8_t>, const BasicTruthTable<Wires>&, std::vector<GateMode>, bool, const SolveOptions&);
+LOGIC_FOR_EACH_WIRES(INSTANTIATE)
+#undef INSTANTIATE
@@ -0,0 +1,156 @@
+#include "sequentialCircuit.h"
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <array>
+#include <map>
+#include <chrono>
+
+using namespace logic;
+
+
+
+
+template<typename Wires>
+std::optional<BasicSequentialCircuit<Wires>> BasicSequentialCircuit<Wires>::solveMinimal(
+    const TruthTable& truthTable,
+    uint8_t outputs,
+    std::vector<GateMode> modes,
+    uint8_t gateBudget,
+    bool balanced,
+    const SolveOptions& options
+) {
+    const uint16_t nInputs  = truthTable.inputWidth();
+    const uint16_t nOutputs = outputs;
+    if (nInputs > UINT8_MAX)
+        throw std::invalid_argument("Solver expects layers of up to 255 wires.");
+    if (nInputs == 0 or nOutputs == 0)
+        throw std::invalid_argument("Solver expects a truth table with input bits and at least one output.");
+    if (options.shards > 1 or !options.checkpoint.empty())
+        throw std::invalid_argument("Shards and checkpoints apply to the search of a single layer size configuration.");
+    if (options.engine == SolveOptions::Engine::LOCAL)
+        throw std::invalid_argument("Minimal circuits are searched by exhaustive engines.");
+
+    std::sort(modes.begin(), modes.end());
+    const TruthTable table = truthTable.compacted(nOutputs);
+
+    // layer builders shared by configurations with the same layer 
+    // size and offsets, indexed by (size, input offset, gate offset)
+    std::map<std::array<uint16_t, 3>, LayerBuilder> builders;
+
+    auto getBuilder = [&](uint8_t size, uint16_t inputOffset, uint16_t gateOffset) -> const LayerBuilder&
+    {
+        auto it = builders.find({ size, inputOffset, gateOffset });
+        if (it != builders.end()) return it->second;
+
+        auto start = std::chrono::steady_clock::now();
+        LayerBuilder builder(size, inputOffset, gateOffset, modes, balanced);
+
+        // distinct first layers are shared by all configurations 
+        // starting with a hidden layer of this size
+        if (gateOffset == nInputs and builder.combinations > 0 and builder.combinations <= 1ul << 24 and
+            (options.pruneEquivalent or options.pruneRedundant))
+            selectDistinctFirstLayers(builder, table, balanced, options);
+        if (gateOffset == nInputs and options.orderCandidates)
+            orderFirstLayers(builder, table, balanced);
+
+        if (options.stats)
+            options.stats->buildSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        return builders.emplace(std::array<uint16_t, 3>{ size, inputOffset, gateOffset }, std::move(builder)).first->second;
+    };
+
+
+    // search configurations by total hidden gates, then depth
+
+    std::vector<uint8_t> layerSizes;
+    std::optional<BasicSequentialCircuit> circuit;
+
+    std::function<bool(uint8_t, uint8_t)> searchCompositions = [&](uint8_t gates, uint8_t depth) -> bool
+    {
+        if (depth == 0)
+        {
+            if (gates > 0) return false;
+
+            layerSizes.push_back(nOutputs);
+
+            if (options.progress)
+            {
+                std::cout << "layer sizes: {";
+                for (uint8_t i = 0; i < layerSizes.size(); i++)
+                    std::cout << (i ? ", " : " ") << (int)layerSizes[i];
+                std::cout << " }" << std::endl;
+            }
+
+            // configurations searched before are answered by the cache
+            const SolutionCache cache{ options.cache };
+            SolutionCache::Result cached;
+            if constexpr (std::is_same_v<Wires, uint64_t>)
+                if (!options.cache.empty())
+                    cached = cache.lookup(table, layerSizes, modes, balanced, options);
+
+            if (cached.cached)
+            {
+                if (options.stats) options.stats->cachedResults++;
+                if constexpr (std::is_same_v<Wires, uint64_t>)
+                    circuit = cached.solution;
+            }
+            else if (options.engine == SolveOptions::Engine::SAT)
+                circuit = solveSAT(layerSizes, table, modes, balanced, options);
+            else
+            {
+                // copies of the shared builders share their selections,
+                // the activation tables are computed by each search
+                std::vector<LayerBuilder> layerBuilders;
+                uint16_t g = 0;
+                for (uint8_t i = 1; i < layerSizes.size() - 1; i++)
+                {
+                    uint16_t inputOffset = balanced ? g : 0;
+                    g += layerSizes[i - 1];
+                    layerBuilders.push_back(getBuilder(layerSizes[i], inputOffset, g));
+                }
+                circuit = options.engine == SolveOptions::Engine::BIDIRECTIONAL ?
+                    searchBidirectional(layerSizes, layerBuilders, table, modes, balanced, options) :
+                    search(layerSizes, layerBuilders, table, modes, balanced, options);
+            }
+
+            if constexpr (std::is_same_v<Wires, uint64_t>)
+                if (!options.cache.empty() and !cached.cached)
+                    cache.store(table, layerSizes, modes, balanced, options, circuit);
+
+            layerSizes.pop_back();
+            return circuit.has_value();
+        }
+
+        for (uint8_t size = 1; size + depth - 1 <= gates; size++)
+        {
+            layerSizes.push_back(size);
+            bool found = searchCompositions(gates - size, depth - 1);
+            layerSizes.pop_back();
+            if (found) return true;
+        }
+        return false;
+    };
+
+    layerSizes.push_back(nInputs);
+    for (uint8_t gates = 0; gates <= gateBudget; gates++)
+        for (uint8_t depth = gates ? 1 : 0; depth <= gates; depth++)
+            if (searchCompositions(gates, depth))
+            {
+                if (!circuit->satisfies(truthTable))
+                    throw std::logic_error("Solution does not satisfy the truth table.");
+                return circuit;
+            }
+
+    return {};
+}
+
+
+
+
+#define INSTANTIATE(Wires) \
+    template std::optional<BasicSequentialCircuit<Wires>> BasicSequentialCircuit<Wires>::solveMinimal( \
+        const BasicTruthTable<Wires>&, uint8_t, std::vector<GateMode>, uint8_t, bool, const SolveOptions&);
+LOGIC_FOR_EACH_WIRES(INSTANTIATE)
+#undef INSTANTIATE
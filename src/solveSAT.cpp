@@ -0,0 +1,245 @@
+#include "sequentialCircuit.h"
+#include "cdcl.h"
+#include <iostream>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace logic;
+using Literal = CDCLSolver::Literal;
+
+
+
+
+// builds CNF for gate functions, folding constant literals
+struct CircuitEncoder
+{
+    CDCLSolver solver;
+    Literal T;
+    Literal F;
+
+    CircuitEncoder()
+    {
+        T = CDCLSolver::literal(solver.newVariable());
+        F = T ^ 1;
+        solver.addClause({ T });
+    }
+
+    Literal variable()
+    {
+        return CDCLSolver::literal(solver.newVariable());
+    }
+
+    Literal conjunction(Literal a, Literal b)
+    {
+        if (a == F or b == F or a == (b ^ 1)) return F;
+        if (a == T or a == b) return b;
+        if (b == T) return a;
+
+        Literal v = variable();
+        solver.addClause({ v ^ 1, a });
+        solver.addClause({ v ^ 1, b });
+        solver.addClause({ v, a ^ 1, b ^ 1 });
+        return v;
+    }
+
+    Literal disjunction(std::vector<Literal> literals)
+    {
+        std::erase(literals, F);
+        if (std::find(literals.begin(), literals.end(), T) != literals.end()) return T;
+        if (literals.empty()) return F;
+        if (literals.size() == 1) return literals.front();
+
+        Literal v = variable();
+        for (Literal l : literals)
+            solver.addClause({ v, l ^ 1 });
+        literals.push_back(v ^ 1);
+        solver.addClause(literals);
+        return v;
+    }
+
+    Literal exclusive(Literal a, Literal b)
+    {
+        if (a == F) return b;
+        if (b == F) return a;
+        if (a == T) return b ^ 1;
+        if (b == T) return a ^ 1;
+        if (a == b) return F;
+        if (a == (b ^ 1)) return T;
+
+        Literal v = variable();
+        solver.addClause({ v ^ 1, a, b });
+        solver.addClause({ v ^ 1, a ^ 1, b ^ 1 });
+        solver.addClause({ v, a ^ 1, b });
+        solver.addClause({ v, a, b ^ 1 });
+        return v;
+    }
+};
+
+
+// selection variables of a gate
+struct GateEncoding
+{
+    std::vector<Literal> inputs;    // per visible wire
+    std::vector<Literal> modes;     // per allowed mode
+};
+
+
+
+
+template<typename Wires>
+std::optional<BasicSequentialCircuit<Wires>> BasicSequentialCircuit<Wires>::solveSAT(
+    const std::vector<uint8_t>& layerSizes,
+    const TruthTable& truthTable,
+    const std::vector<GateMode>& modes,
+    bool balanced,
+    const SolveOptions& options
+) {
+    using enum GateMode;
+
+    CircuitEncoder encoder;
+    const Literal T = encoder.T, F = encoder.F;
+
+    bool needAnd = false, needOr = false, needXor = false;
+    for (auto m : modes)
+    {
+        needAnd |= (uint8_t(m) & 3) == uint8_t(AND);
+        needOr  |= (uint8_t(m) & 3) == uint8_t(OR);
+        needXor |= (uint8_t(m) & 3) == uint8_t(XOR);
+    }
+
+
+    // prepare circuit layers and wire literals of all rows
+
+    const uint64_t nRows  = truthTable.entries.size();
+    const uint16_t nWires = std::reduce(layerSizes.begin(), layerSizes.end() - 1, 0);
+    if (std::max<uint16_t>(nWires, layerSizes.back()) > wireCapacity<Wires>)
+        throw std::overflow_error("Circuit wires exceed the " + std::to_string(wireCapacity<Wires>) + " bit wire state.");
+
+    BasicSequentialCircuit circuit;
+    circuit.layers.resize(layerSizes.size());
+    uint16_t g = 0;
+    for (uint8_t l = 0; l < layerSizes.size(); l++)
+    {
+        circuit.layers[l].inputOffset = balanced and l > 1 ? g - layerSizes[l - 1] : 0;
+        circuit.layers[l].gateOffset = g;
+        circuit.layers[l].gates.resize(layerSizes[l], { 0, l == 0 ? IN : modes.front() });
+        g += layerSizes[l];
+    }
+
+    // wires[w * nRows + r]
+    std::vector<Literal> wires(nWires * nRows);
+    for (uint64_t r = 0; r < nRows; r++)
+        for (uint8_t w = 0; w < layerSizes.front(); w++)
+            wires[w * nRows + r] = testWire(truthTable.entries[r].inputBits, w) ? T : F;
+
+
+    // encode gates layer by layer
+
+    std::vector<std::vector<GateEncoding>> encodings(layerSizes.size());
+    for (uint8_t l = 1; l < layerSizes.size(); l++)
+    {
+        const Layer& layer = circuit.layers[l];
+        const bool output = l == layerSizes.size() - 1;
+
+        for (uint8_t g = 0; g < layer.gates.size(); g++)
+        {
+            GateEncoding gate;
+
+            // at least one input, exactly one mode
+            for (uint16_t w = layer.inputOffset; w < layer.gateOffset; w++)
+                gate.inputs.push_back(encoder.variable());
+            encoder.solver.addClause(gate.inputs);
+
+            for (uint8_t m = 0; m < modes.size(); m++)
+                gate.modes.push_back(encoder.variable());
+            encoder.solver.addClause(gate.modes);
+            for (uint8_t a = 0; a < modes.size(); a++)
+                for (uint8_t b = a + 1; b < modes.size(); b++)
+                    encoder.solver.addClause({ gate.modes[a] ^ 1, gate.modes[b] ^ 1 });
+
+            for (uint64_t r = 0; r < nRows; r++)
+            {
+                const auto& entry = truthTable.entries[r];
+                if (output and testWire(entry.dontCareBits, g)) continue;
+
+                // base functions over the selected inputs
+                std::vector<Literal> selectedOn, selectedOff;
+                for (uint16_t i = 0; i < gate.inputs.size(); i++)
+                {
+                    Literal x = wires[(layer.inputOffset + i) * nRows + r];
+                    if (needOr or needXor) selectedOn.push_back(encoder.conjunction(gate.inputs[i], x));
+                    if (needAnd)           selectedOff.push_back(encoder.conjunction(gate.inputs[i], x ^ 1));
+                }
+
+                Literal base[4] = { F, F, F, F };
+                if (needAnd) base[uint8_t(AND)] = encoder.disjunction(selectedOff) ^ 1;
+                if (needOr)  base[uint8_t(OR)]  = encoder.disjunction(selectedOn);
+                if (needXor)
+                    for (Literal on : selectedOn)
+                        base[uint8_t(XOR)] = encoder.exclusive(base[uint8_t(XOR)], on);
+
+                // gate value, fixed to the target for output gates
+                Literal v = output ? (testWire(entry.outputBits, g) ? T : F) : encoder.variable();
+                if (!output)
+                    wires[(layer.gateOffset + g) * nRows + r] = v;
+
+                // selected mode determines the gate value
+                for (uint8_t m = 0; m < modes.size(); m++)
+                {
+                    Literal f = base[uint8_t(modes[m]) & 3] ^ (uint8_t(modes[m]) >> 2);
+                    encoder.solver.addClause({ gate.modes[m] ^ 1, v ^ 1, f });
+                    encoder.solver.addClause({ gate.modes[m] ^ 1, v, f ^ 1 });
+                }
+            }
+
+            encodings[l].push_back(gate);
+        }
+    }
+
+    if (options.progress)
+        std::cout << "sat variables: " << encoder.solver.variables() << std::endl;
+
+
+    // solve and decode gate masks and modes
+
+    auto result = encoder.solver.solve();
+    if (options.progress)
+        std::cout << "sat conflicts: " << encoder.solver.conflicts
+                  << ", decisions: " << encoder.solver.decisions << std::endl;
+
+    if (result != CDCLSolver::Result::SAT)
+        return {};
+
+    for (uint8_t l = 1; l < layerSizes.size(); l++)
+    {
+        Layer& layer = circuit.layers[l];
+        for (uint8_t g = 0; g < layer.gates.size(); g++)
+        {
+            const GateEncoding& gate = encodings[l][g];
+
+            layer.gates[g].inputMask = 0;
+            for (uint16_t i = 0; i < gate.inputs.size(); i++)
+                if (encoder.solver.value(gate.inputs[i] >> 1))
+                    layer.gates[g].inputMask |= wireBit<Wires>(layer.inputOffset + i);
+
+            for (uint8_t m = 0; m < modes.size(); m++)
+                if (encoder.solver.value(gate.modes[m] >> 1))
+                    layer.gates[g].mode = modes[m];
+        }
+    }
+
+    if (!circuit.satisfies(truthTable))
+        throw std::logic_error("SAT solution does not satisfy the truth table.");
+
+    return circuit;
+}
+
+
+
+
+#define INSTANTIATE(Wires) \
+    template std::optional<BasicSequentialCircuit<Wires>> BasicSequentialCircuit<Wires>::solveSAT( \
+        const std::vector<uint8_t>&, const BasicTruthTable<Wires>&, const std::vector<GateMode>&, bool, const SolveOptions&);
+LOGIC_FOR_EACH_WIRES(INSTANTIATE)
+#undef INSTANTIATE
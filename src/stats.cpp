@@ -0,0 +1,59 @@
+#include "sequentialCircuit.h"
+#include <sstream>
+
+using namespace logic;
+
+
+
+
+SearchStats& SearchStats::operator+=(const SearchStats& other)
+{
+    combinations         += other.combinations;
+    skipped              += other.skipped;
+    layersUnranked       += other.layersUnranked;
+    prunedRedundant      += other.prunedRedundant;
+    prunedEquivalent     += other.prunedEquivalent;
+    prunedBound          += other.prunedBound;
+    outputChecks         += other.outputChecks;
+    rejectedInseparable  += other.rejectedInseparable;
+    cacheHits            += other.cacheHits;
+    outputCandidates     += other.outputCandidates;
+    rowsScanned          += other.rowsScanned;
+    middleStates         += other.middleStates;
+    cachedResults        += other.cachedResults;
+    localMoves           += other.localMoves;
+    localRestarts        += other.localRestarts;
+    buildSeconds         += other.buildSeconds;
+    searchSeconds        += other.searchSeconds;
+    firstSolutionSeconds += other.firstSolutionSeconds;
+    return *this;
+}
+
+
+
+
+std::string SearchStats::toJSON() const
+{
+    std::stringstream ss;
+    ss << "{\n"
+       << "  \"combinations\": "         << combinations         << ",\n"
+       << "  \"skipped\": "              << skipped              << ",\n"
+       << "  \"layersUnranked\": "       << layersUnranked       << ",\n"
+       << "  \"prunedRedundant\": "      << prunedRedundant      << ",\n"
+       << "  \"prunedEquivalent\": "     << prunedEquivalent     << ",\n"
+       << "  \"prunedBound\": "          << prunedBound          << ",\n"
+       << "  \"outputChecks\": "         << outputChecks         << ",\n"
+       << "  \"rejectedInseparable\": "  << rejectedInseparable  << ",\n"
+       << "  \"cacheHits\": "            << cacheHits            << ",\n"
+       << "  \"outputCandidates\": "     << outputCandidates     << ",\n"
+       << "  \"rowsScanned\": "          << rowsScanned          << ",\n"
+       << "  \"middleStates\": "         << middleStates         << ",\n"
+       << "  \"cachedResults\": "        << cachedResults        << ",\n"
+       << "  \"localMoves\": "           << localMoves           << ",\n"
+       << "  \"localRestarts\": "        << localRestarts        << ",\n"
+       << "  \"buildSeconds\": "         << buildSeconds         << ",\n"
+       << "  \"searchSeconds\": "        << searchSeconds        << ",\n"
+       << "  \"firstSolutionSeconds\": " << firstSolutionSeconds << "\n"
+       << "}\n";
+    return ss.str();
+}
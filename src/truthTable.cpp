@@ -1,40 +1,433 @@
 #include "sequentialCircuit.h"
 #include <fstream>
+#include <random>
+#include <stdexcept>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <type_traits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
+using namespace logic;
 
 
 
-logic::TruthTable logic::TruthTable::readCSV(std::string filename)
+
+// read-only memory mapping of a whole file
+struct MappedFile
+{
+    const char* data = nullptr;
+    size_t size = 0;
+
+    explicit MappedFile(const std::string& filename)
+    {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("Cannot open truth table " + filename + ".");
+
+        struct stat status;
+        if (fstat(fd, &status) != 0)
+        {
+            close(fd);
+            throw std::runtime_error("Cannot read truth table " + filename + ".");
+        }
+        size = status.st_size;
+
+        if (size > 0)
+        {
+            void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED)
+            {
+                close(fd);
+                throw std::runtime_error("Cannot map truth table " + filename + ".");
+            }
+            madvise(mapping, size, MADV_SEQUENTIAL);
+            data = (const char*)mapping;
+        }
+        close(fd);
+    }
+
+    ~MappedFile()
+    {
+        if (data) munmap((void*)data, size);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+};
+
+
+// binary tables start with this header followed by the packed rows,
+// the input, output and dont care bits of a row take fieldWords
+// little-endian words each
+struct BinaryHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint16_t inputWidth;
+    uint16_t outputWidth;
+    uint32_t fieldWords;
+    uint64_t rows;
+};
+static_assert(sizeof(BinaryHeader) == 24);
+
+static constexpr char binaryMagic[4] = { 'S', 'L', 'T', 'T' };
+static constexpr uint32_t binaryVersion = 1;
+
+
+
+
+// decimal number at the cursor, which is advanced past its digits
+template<typename Wires>
+static std::errc parseWires(const char*& cursor, const char* end, Wires& value)
+{
+    if constexpr (std::is_same_v<Wires, uint64_t>)
+    {
+        auto [next, error] = std::from_chars(cursor, end, value);
+        cursor = next;
+        return error;
+    }
+    else
+    {
+        // one spare word catches numbers exceeding the wire state
+        constexpr unsigned words = wireCapacity<Wires> / 64;
+        WideWires<words + 1> wide = 0;
+
+        const char* begin = cursor;
+        for (; cursor < end and *cursor >= '0' and *cursor <= '9'; cursor++)
+        {
+            wide = (wide << 3) + (wide << 1) + WideWires<words + 1>(*cursor - '0');
+            if (wide.words[words])
+                return std::errc::result_out_of_range;
+        }
+        if (cursor == begin)
+            return std::errc::invalid_argument;
+
+        value = convertWires<Wires>(wide);
+        return {};
+    }
+}
+
+static void skipSpaces(const char*& cursor, const char* end)
 {
-    std::ifstream file(filename);
+    while (cursor < end and (*cursor == ' ' or *cursor == '\t' or *cursor == '\r'))
+        cursor++;
+}
+
+template<typename Wires>
+BasicTruthTable<Wires> BasicTruthTable<Wires>::readCSV(std::string filename)
+{
+    MappedFile file(filename);
+    const char* cursor = file.data;
+    const char* end    = file.data + file.size;
+
+    auto fail = [&](uint64_t line, const std::string& message)
+    {
+        throw std::runtime_error(filename + ":" + std::to_string(line) + ": " + message);
+    };
 
-    if (!file.is_open()) return {};
+    BasicTruthTable table;
+    table.entries.reserve(std::count(cursor, end, '\n'));
 
-    logic::TruthTable table;
-    std::string line;
-    std::getline(file, line);
-    while (std::getline(file, line))
+    // first line is the column header
+    for (uint64_t line = 1; cursor < end; line++)
     {
-        if (line.empty()) continue;
+        const char* lineEnd = (const char*)std::memchr(cursor, '\n', end - cursor);
+        if (!lineEnd) lineEnd = end;
+
+        const char* c = cursor;
+        cursor = lineEnd + 1;
+        if (line == 1) continue;
 
-        table.entries.push_back({});
+        skipSpaces(c, lineEnd);
+        if (c == lineEnd) continue;
 
-        size_t begin = 0, end;
-        end = line.find(',', begin);
-        table.entries.back().inputBits = std::stoull(line.substr(begin, end - begin));
-        if (end == std::string::npos) continue;
+        // input, output and dont care bits, missing trailing fields are 0
+        Entry entry = { 0, 0, 0 };
+        for (Wires* field : { &entry.inputBits, &entry.outputBits, &entry.dontCareBits })
+        {
+            std::errc error = parseWires(c, lineEnd, *field);
+            if (error == std::errc::result_out_of_range)
+                fail(line, "number exceeds " + std::to_string(wireCapacity<Wires>) + " bits");
+            if (error != std::errc())
+                fail(line, "expected a number");
 
-        begin = end + 1;
-        end = line.find(',', begin);
-        table.entries.back().outputBits = std::stoull(line.substr(begin, end - begin));
-        if (end == std::string::npos) continue;
+            skipSpaces(c, lineEnd);
+            if (c == lineEnd) break;
+            if (*c != ',')
+                fail(line, "expected a comma");
+            c++;
 
-        begin = end + 1;
-        end = std::string::npos;
-        table.entries.back().dontCareBits = std::stoull(line.substr(begin, end - begin));
+            skipSpaces(c, lineEnd);
+            if (c == lineEnd) break;
+        }
+        if (c != lineEnd)
+            fail(line, "unexpected field after the dont care bits");
+
+        table.entries.push_back(entry);
     }
 
-    file.close();
+    return table;
+}
+
+
+
+
+template<typename Wires>
+static Wires wiresFromWords(const uint64_t* words, uint32_t count)
+{
+    Wires bits = 0;
+    for (uint32_t w = 0; w < count and w < wireCapacity<Wires> / 64; w++)
+        bits |= Wires(words[w]) << (64 * w);
+    return bits;
+}
+
+template<typename Wires>
+BasicTruthTable<Wires> BasicTruthTable<Wires>::readBinary(std::string filename)
+{
+    MappedFile file(filename);
+
+    BinaryHeader header;
+    if (file.size < sizeof(header))
+        throw std::runtime_error("Invalid truth table " + filename + ": missing header");
+    std::memcpy(&header, file.data, sizeof(header));
+
+    if (std::memcmp(header.magic, binaryMagic, sizeof(binaryMagic)) != 0)
+        throw std::runtime_error("Invalid truth table " + filename + ": not a binary table");
+    if (header.version != binaryVersion)
+        throw std::runtime_error("Invalid truth table " + filename + ": unsupported version " + std::to_string(header.version));
+    if (std::max(header.inputWidth, header.outputWidth) > wireCapacity<Wires>)
+        throw std::runtime_error("Truth table " + filename + " exceeds " + std::to_string(wireCapacity<Wires>) + " bits.");
+
+    const uint64_t rowWords = 3ul * header.fieldWords;
+    if (header.fieldWords == 0 or (file.size - sizeof(header)) / 8 / rowWords != header.rows or
+        (file.size - sizeof(header)) % (8 * rowWords) != 0)
+        throw std::runtime_error("Invalid truth table " + filename + ": size does not match " + std::to_string(header.rows) + " rows");
+
+    const uint64_t* words = (const uint64_t*)(file.data + sizeof(header));
+
+    BasicTruthTable table;
+    table.entries.resize(header.rows);
+
+    // rows of the same layout as trivial entries are copied at once,
+    // wide wire states zero their words on construction
+    if constexpr (std::is_trivial_v<Entry>)
+        if (sizeof(Entry) == 8 * rowWords)
+        {
+            std::memcpy(table.entries.data(), words, header.rows * sizeof(Entry));
+            return table;
+        }
+
+    for (auto& entry : table.entries)
+    {
+        entry.inputBits    = wiresFromWords<Wires>(words, header.fieldWords); words += header.fieldWords;
+        entry.outputBits   = wiresFromWords<Wires>(words, header.fieldWords); words += header.fieldWords;
+        entry.dontCareBits = wiresFromWords<Wires>(words, header.fieldWords); words += header.fieldWords;
+    }
 
     return table;
 }
+
+template<typename Wires>
+void BasicTruthTable<Wires>::writeBinary(std::string filename) const
+{
+    BinaryHeader header;
+    std::memcpy(header.magic, binaryMagic, sizeof(binaryMagic));
+    header.version     = binaryVersion;
+    header.inputWidth  = inputWidth();
+    header.outputWidth = outputWidth();
+    header.fieldWords  = std::max(1, (std::max(header.inputWidth, header.outputWidth) + 63) / 64);
+    header.rows        = entries.size();
+
+    std::vector<uint64_t> words;
+    words.reserve(3 * header.fieldWords * entries.size());
+    for (auto& entry : entries)
+        for (const Wires* bits : { &entry.inputBits, &entry.outputBits, &entry.dontCareBits })
+            for (uint32_t w = 0; w < header.fieldWords; w++)
+                words.push_back(lowWord(*bits >> (64 * w)));
+
+    std::ofstream file(filename, std::ios::binary);
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)words.data(), words.size() * sizeof(uint64_t));
+    if (!file.flush())
+        throw std::runtime_error("Cannot write truth table " + filename + ".");
+}
+
+template<typename Wires>
+BasicTruthTable<Wires> BasicTruthTable<Wires>::read(std::string filename)
+{
+    char magic[sizeof(binaryMagic)] = {};
+    std::ifstream(filename, std::ios::binary).read(magic, sizeof(magic));
+
+    if (std::memcmp(magic, binaryMagic, sizeof(binaryMagic)) == 0)
+        return readBinary(filename);
+    return readCSV(filename);
+}
+
+
+
+
+template<typename Wires>
+uint16_t BasicTruthTable<Wires>::inputWidth() const
+{
+    Wires bits = 0;
+    for (auto& entry : entries) bits |= entry.inputBits;
+    return wireWidth(bits);
+}
+
+template<typename Wires>
+uint16_t BasicTruthTable<Wires>::outputWidth() const
+{
+    Wires bits = 0;
+    for (auto& entry : entries) bits |= entry.outputBits | entry.dontCareBits;
+    return wireWidth(bits);
+}
+
+
+
+
+template<typename Wires>
+uint64_t BasicTruthTable<Wires>::hash() const
+{
+    // fnv-1a over the entry words, words above the widest
+    // entry are skipped to hash equally in any wire state
+    uint16_t words = 1;
+    for (auto& entry : entries)
+        for (const Wires* bits : { &entry.inputBits, &entry.outputBits, &entry.dontCareBits })
+            words = std::max<uint16_t>(words, (wireWidth(*bits) + 63) / 64);
+
+    uint64_t h = 0xcbf29ce484222325;
+    for (auto& entry : entries)
+        for (const Wires* bits : { &entry.inputBits, &entry.outputBits, &entry.dontCareBits })
+            for (uint16_t w = 0; w < words; w++)
+            {
+                uint64_t word = lowWord(*bits >> (64 * w));
+                for (uint8_t b = 0; b < 64; b += 8)
+                    h = (h ^ (word >> b & 0xff)) * 0x100000001b3;
+            }
+    return h;
+}
+
+
+
+
+template<typename Wires>
+BasicTruthTable<Wires> BasicTruthTable<Wires>::compacted(uint16_t outputs) const
+{
+    const Wires outputMask = lowWires<Wires>(outputs);
+
+    // rows with cared outputs, grouped by equal inputs in row order
+    std::vector<uint64_t> order;
+    for (uint64_t r = 0; r < entries.size(); r++)
+        if (outputMask & ~entries[r].dontCareBits) order.push_back(r);
+    if (order.empty())
+        return { std::vector<Entry>(entries.begin(), entries.begin() + std::min<size_t>(entries.size(), 1)) };
+
+    std::stable_sort(order.begin(), order.end(), [&](uint64_t a, uint64_t b)
+        { return wiresLess(entries[a].inputBits, entries[b].inputBits); });
+
+    // merged rows with the index of their first row
+    std::vector<std::pair<uint64_t, Entry>> merged;
+    for (uint64_t i = 0, group = 0; i < order.size(); i++)
+    {
+        const Entry& entry = entries[order[i]];
+        if (i > 0 and !(entry.inputBits == entries[order[i - 1]].inputBits))
+            group = merged.size();
+
+        const Wires care = outputMask & ~entry.dontCareBits;
+        auto into = std::find_if(merged.begin() + group, merged.end(), [&](const auto& row)
+        {
+            return !((entry.outputBits ^ row.second.outputBits) & care & ~row.second.dontCareBits);
+        });
+
+        if (into == merged.end())
+            merged.push_back({ order[i], { entry.inputBits, entry.outputBits & care, entry.dontCareBits & outputMask } });
+        else
+        {
+            into->second.outputBits |= entry.outputBits & care;
+            into->second.dontCareBits &= entry.dontCareBits;
+        }
+    }
+
+    std::sort(merged.begin(), merged.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    BasicTruthTable table;
+    for (auto& row : merged)
+        table.entries.push_back(row.second);
+    return table;
+}
+
+
+
+
+template<typename Wires>
+BasicTruthTable<Wires> BasicTruthTable<Wires>::adder(uint8_t bits)
+{
+    BasicTruthTable table;
+    const uint64_t mask = (1ul << bits) - 1;
+    for (uint64_t i = 0; i < 1ul << (2 * bits); i++)
+        table.entries.push_back({ i, (i & mask) + (i >> bits), 0 });
+    return table;
+}
+
+template<typename Wires>
+BasicTruthTable<Wires> BasicTruthTable<Wires>::popcount(uint8_t bits)
+{
+    BasicTruthTable table;
+    for (uint64_t i = 0; i < 1ul << bits; i++)
+        table.entries.push_back({ i, (uint64_t)__builtin_popcountll(i), 0 });
+    return table;
+}
+
+template<typename Wires>
+BasicTruthTable<Wires> BasicTruthTable<Wires>::comparator(uint8_t bits)
+{
+    BasicTruthTable table;
+    const uint64_t mask = (1ul << bits) - 1;
+    for (uint64_t i = 0; i < 1ul << (2 * bits); i++)
+    {
+        uint64_t a = i & mask, b = i >> bits;
+        table.entries.push_back({ i, uint64_t(a < b) | uint64_t(a == b) << 1 | uint64_t(a > b) << 2, 0 });
+    }
+    return table;
+}
+
+template<typename Wires>
+BasicTruthTable<Wires> BasicTruthTable<Wires>::multiplexer(uint8_t selectBits)
+{
+    BasicTruthTable table;
+    const uint8_t inputs = selectBits + (1 << selectBits);
+    const uint64_t mask = (1ul << selectBits) - 1;
+    for (uint64_t i = 0; i < 1ul << inputs; i++)
+        table.entries.push_back({ i, i >> (selectBits + (i & mask)) & 1, 0 });
+    return table;
+}
+
+template<typename Wires>
+BasicTruthTable<Wires> BasicTruthTable<Wires>::random(uint8_t inputs, uint8_t outputs, uint64_t seed, double dontCareRate)
+{
+    BasicTruthTable table;
+    std::mt19937_64 rng(seed);
+    std::bernoulli_distribution dontCare(dontCareRate);
+    for (uint64_t i = 0; i < 1ul << inputs; i++)
+    {
+        Wires outputBits = 0, dontCareBits = 0;
+        for (uint8_t o = 0; o < outputs; o++)
+            if (dontCare(rng)) dontCareBits |= wireBit<Wires>(o);
+        for (uint8_t o = 0; o < outputs; o += 64)
+            outputBits |= Wires(rng()) << o;
+
+        table.entries.push_back({ i, outputBits & lowWires<Wires>(outputs) & ~dontCareBits, dontCareBits });
+    }
+    return table;
+}
+
+
+
+
+#define INSTANTIATE(Wires) template struct logic::BasicTruthTable<Wires>;
+LOGIC_FOR_EACH_WIRES(INSTANTIATE)
+#undef INSTANTIATE
@@ -17,6 +17,20 @@ uint64_t combinationsWReplacements(uint64_t n, uint64_t k)
     return x;
 }
 
+uint64_t binomial(uint64_t n, uint64_t k)
+{
+    if (k > n) return 0;
+    if (k > n - k) k = n - k;
+
+    unsigned __int128 x = 1;
+    for (uint64_t i = 1; i <= k; i++)
+    {
+        x = x * (n - k + i) / i;
+        if (x > UINT64_MAX) return UINT64_MAX;
+    }
+    return x;
+}
+
 
 
 
@@ -0,0 +1,203 @@
+#include "sequentialCircuit.h"
+#include <iostream>
+#include <functional>
+#include <filesystem>
+
+using namespace logic;
+using Mode = SequentialCircuit::Gate::Mode;
+using enum Mode;
+
+
+
+
+// table of rows of input and output bits, all outputs cared for
+static TruthTable table(std::initializer_list<std::pair<uint64_t, uint64_t>> rows)
+{
+    TruthTable t;
+    for (auto [in, out] : rows)
+        t.entries.push_back({ in, out, 0 });
+    return t;
+}
+
+static SolveOptions quiet()
+{
+    SolveOptions options;
+    options.progress = false;
+    return options;
+}
+
+
+
+
+// output = b of inputs a | b << 1, every monotone column exists after
+// the first hidden layer, so all second layers duplicate visible wires
+static bool redundantLayers()
+{
+    TruthTable t = table({ { 0, 0 }, { 1, 0 }, { 2, 1 }, { 3, 1 } });
+    auto circuit = SequentialCircuit::solve({ 2, 2, 1, 1 }, t, { AND, OR }, false, quiet());
+    return circuit and circuit->satisfies(t);
+}
+
+
+// no first hidden layer of four distinct AND gates exists over two
+// inputs, the deepening reaches it without finding a circuit
+static bool emptyMinimalLayer()
+{
+    TruthTable t = table({ { 0, 0 }, { 1, 1 }, { 2, 1 }, { 3, 0 } });
+    auto circuit = SequentialCircuit::solveMinimal(t, 1, { AND }, 4, true, quiet());
+    return !circuit;
+}
+
+
+// three distinct XNOR gates do not exist over two balanced inputs,
+// the ordered enumeration selects and orders an empty first layer
+static bool emptyOrderedLayer()
+{
+    TruthTable t;
+    t.entries = { { 3, 0, 1 }, { 1, 1, 0 } };
+    SolveOptions options = quiet();
+    options.orderCandidates = true;
+    auto circuit = SequentialCircuit::solve({ 2, 3, 1 }, t, { XNOR }, true, options);
+    return !circuit;
+}
+
+
+// all outputs are cared zeros, compacting the table must keep its rows
+static bool zeroTable()
+{
+    TruthTable t = table({ { 2, 0 }, { 4, 0 }, { 6, 0 }, { 3, 0 } });
+    auto circuit = SequentialCircuit::solve({ 3, 1, 1 }, t, { OR, XOR }, true, quiet());
+    return !circuit or circuit->satisfies(t);
+}
+
+
+// no layer of four distinct AND gates exists over two inputs, which
+// says nothing about narrower layers of the cached problem
+static bool cachedWiderLayers()
+{
+    const auto directory = std::filesystem::temp_directory_path() / "regression_cache";
+    std::filesystem::remove_all(directory);
+
+    TruthTable t = table({ { 0, 0 }, { 1, 0 }, { 2, 0 }, { 3, 1 } });
+    SolveOptions options = quiet();
+    options.cache = directory.string();
+
+    bool passed = !SequentialCircuit::solve({ 2, 4, 1 }, t, { AND }, false, options);
+    auto circuit = SequentialCircuit::solve({ 2, 1, 1 }, t, { AND }, false, options);
+    passed = passed and circuit and circuit->satisfies(t);
+
+    std::filesystem::remove_all(directory);
+    return passed;
+}
+
+
+// output gates of the kernels specialized on the base modes of a mode
+// set match those of the generic kernel for all mode sets
+static bool specializedOutputGates()
+{
+    return selfTestOutputGates(TruthTable::adder(2)) and
+        selfTestOutputGates(TruthTable::comparator(2)) and
+        selfTestOutputGates(TruthTable::random(5, 2, 3, 0.25));
+}
+
+
+// outputs of all 64 wires of the state must be checked
+static bool fullWidthOutputs()
+{
+    SequentialCircuit circuit;
+    circuit.layers.resize(2);
+    circuit.layers[0].gates = { { 0, IN } };
+    circuit.layers[1].gateOffset = 1;
+    circuit.layers[1].gates.assign(64, { 1, AND });
+
+    TruthTable t = table({ { 0, ~0ul } });
+    return !circuit.satisfies(t);
+}
+
+
+// random tables of 64 outputs have output bits
+static bool fullWidthRandom()
+{
+    TruthTable t = TruthTable::random(2, 64, 1);
+    return t.outputWidth() == 64;
+}
+
+
+// 77 wires do not fit the 64 bit wire state of the local search
+static bool localWireCapacity()
+{
+    try
+    {
+        SolveOptions options = quiet();
+        options.localSeconds = 0.1;
+        SequentialCircuit::solveLocal({ 4, 40, 30, 3 }, TruthTable::adder(2), { AND, XOR }, true, options);
+    }
+    catch (const std::overflow_error&) { return true; }
+    return false;
+}
+
+
+// a checkpoint of an ordered enumeration is not resumed by an unordered
+// one of the same layer counts, the first layers are in another order
+static bool checkpointOrder()
+{
+    const auto file = std::filesystem::temp_directory_path() / "regression.checkpoint";
+    std::filesystem::remove(file);
+
+    TruthTable t = TruthTable::popcount(3);
+    SolveOptions options = quiet();
+    options.checkpoint = file.string();
+    options.pruneEquivalent = false;
+    options.orderCandidates = true;
+    SequentialCircuit::solve({ 3, 2, 2 }, t, { AND, XOR }, true, options);
+
+    bool passed = false;
+    options.orderCandidates = false;
+    try { SequentialCircuit::solve({ 3, 2, 2 }, t, { AND, XOR }, true, options); }
+    catch (const std::invalid_argument&) { passed = true; }
+
+    std::filesystem::remove(file);
+    return passed;
+}
+
+
+// the second output is a cared zero in all rows, which sets no bits
+// of the table, a & b & (a ^ b) needs one hidden gate
+static bool minimalZeroOutput()
+{
+    TruthTable t = table({ { 0, 0 }, { 1, 1 }, { 2, 0 }, { 3, 1 } });
+    auto circuit = SequentialCircuit::solveMinimal(t, 2, { AND, XOR }, 2, false, quiet());
+    return circuit and circuit->layers.back().gates.size() == 2 and circuit->satisfies(t);
+}
+
+
+
+
+int main()
+{
+    const std::pair<const char*, std::function<bool()>> cases[] = {
+        { "redundant layers", redundantLayers },
+        { "empty minimal layer", emptyMinimalLayer },
+        { "empty ordered layer", emptyOrderedLayer },
+        { "zero table", zeroTable },
+        { "cached wider layers", cachedWiderLayers },
+        { "specialized output gates", specializedOutputGates },
+        { "full width outputs", fullWidthOutputs },
+        { "full width random", fullWidthRandom },
+        { "local wire capacity", localWireCapacity },
+        { "checkpoint order", checkpointOrder },
+        { "minimal zero output", minimalZeroOutput },
+    };
+
+    bool passed = true;
+    for (auto& [name, test] : cases)
+    {
+        bool casePassed = false;
+        try { casePassed = test(); }
+        catch (const std::exception& e) { std::cout << e.what() << "\n"; }
+
+        std::cout << (casePassed ? "passed " : "FAILED ") << name << "\n";
+        passed = passed and casePassed;
+    }
+    return passed ? 0 : 1;
+}